@@ -1,4 +1,5 @@
 #include "checkpoint.h"
+#include "thread_memory_log.h"
 
 #include "../util/stuffs.h"
 #include "../parsing_helper.h"
@@ -10,6 +11,7 @@ checkpoint::checkpoint(UINT32 existing_exec_order, const CONTEXT* p_ctxt,
   this->context = std::make_shared<CONTEXT>(); PIN_SaveContext(p_ctxt, this->context.get());
 
   this->exec_order = existing_exec_order;
+  this->write_sequence = current_write_sequence();
 
   UINT8 mem_buffer[sizeof(std::size_t)];
   PIN_SafeCopy(mem_buffer, reinterpret_cast<UINT8*>(input_mem_read_addr), input_mem_read_size);
@@ -50,15 +52,20 @@ auto checkpoint::mem_write_tracking (ADDRINT mem_addr, UINT32 mem_size) -> void
 
 
 /**
- * @brief restore the execution order and over-written memory addresses
+ * @brief restore the execution order and over-written memory addresses, the addresses written by
+ * other threads are restored first so that ones written by the traced thread take their values
+ * in the checkpoint
  */
 static auto generic_restore (UINT32& existing_exec_order, UINT32 checkpoint_exec_order,
+                             UINT64 checkpoint_write_sequence,
                              addrint_value_map_t& checkpoint_mem_written_log) -> void
 {
   // restore the existing execution order (-1 because the instruction at the checkpoint will
   // be re-executed)
   existing_exec_order = checkpoint_exec_order - 1;
 
+  restore_thread_mem_writes(PIN_ThreadId(), checkpoint_write_sequence);
+
   // restore values of written memory addresses
 //  auto mem_iter = checkpoint_mem_written_log.begin();
 //  for (; mem_iter != checkpoint_mem_written_log.end(); ++mem_iter)
@@ -84,7 +91,8 @@ static auto generic_restore (UINT32& existing_exec_order, UINT32 checkpoint_exec
  */
 auto rollback_with_current_input(ptr_checkpoint_t dest, UINT32& existing_exec_order) -> void
 {
-  generic_restore(existing_exec_order, dest->exec_order, dest->mem_written_log);
+  generic_restore(existing_exec_order, dest->exec_order, dest->write_sequence,
+                  dest->mem_written_log);
 
   // restore values of registers
   PIN_ExecuteAt(dest->context.get());
@@ -97,7 +105,8 @@ auto rollback_with_current_input(ptr_checkpoint_t dest, UINT32& existing_exec_or
  */
 auto rollback_with_original_input(ptr_checkpoint_t dest, UINT32& existing_exec_order) -> void
 {
-  generic_restore(existing_exec_order, dest->exec_order, dest->mem_written_log);
+  generic_restore(existing_exec_order, dest->exec_order, dest->write_sequence,
+                  dest->mem_written_log);
 
   // restore the original input
 //  addrint_value_map_t::iterator mem_iter = dest->input_dep_original_values.begin();
@@ -124,7 +133,8 @@ auto rollback_with_original_input(ptr_checkpoint_t dest, UINT32& existing_exec_o
 auto rollback_with_new_input(ptr_checkpoint_t dest, UINT32& existing_exec_order,
                              ADDRINT input_addr, UINT32 input_size, UINT8* new_buffer) -> void
 {
-  generic_restore(existing_exec_order, dest->exec_order, dest->mem_written_log);
+  generic_restore(existing_exec_order, dest->exec_order, dest->write_sequence,
+                  dest->mem_written_log);
 
   // replace the current input
   PIN_SafeCopy(reinterpret_cast<UINT8*>(input_addr), new_buffer, input_size);
@@ -141,7 +151,8 @@ auto rollback_with_new_input(ptr_checkpoint_t dest, UINT32& existing_exec_order,
 auto rollback_with_modified_input(ptr_checkpoint_t dest, UINT32& existing_exec_order,
                                   addrint_value_map_t& modified_addrs_values) -> void
 {
-  generic_restore(existing_exec_order, dest->exec_order, dest->mem_written_log);
+  generic_restore(existing_exec_order, dest->exec_order, dest->write_sequence,
+                  dest->mem_written_log);
 
   // modify the current input
 //  addrint_value_map_t::iterator mem_iter = modified_addrs_values.begin();
@@ -21,6 +21,9 @@ public:
   
   addrint_value_map_t         input_dep_original_values;
   UINT32                      exec_order;
+
+  // sequence number of memory writes of other threads at the checkpoint
+  UINT64                      write_sequence;
     
 public:
   checkpoint(UINT32 existing_exec_order, const CONTEXT* ptr_context,
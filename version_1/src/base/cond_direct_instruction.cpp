@@ -11,6 +11,7 @@ cond_direct_instruction::cond_direct_instruction(const INS& ins) : instruction(i
   this->first_input_projections.clear(); this->second_input_projections.clear();
 
   this->used_rollback_num = 0; this->is_singular = false;
+  this->path_code = empty_path_code;
 }
 
 
@@ -25,4 +26,5 @@ cond_direct_instruction::cond_direct_instruction(instruction& ins) : instruction
   this->first_input_projections.clear(); this->second_input_projections.clear();
 
   this->used_rollback_num = 0; this->is_singular = false;
+  this->path_code = empty_path_code;
 }
@@ -3,6 +3,8 @@
 
 #include "instruction.h"
 #include "checkpoint.h"
+#include "input_store.h"
+#include "path_code_trie.h"
 
 #include <vector>
 
@@ -17,8 +19,6 @@ typedef std::vector<addrint_value_map_t>            addrint_value_maps_t;
 typedef std::pair<ptr_checkpoint_t, addrint_set_t>  checkpoint_addrs_pair_t;
 typedef std::vector<checkpoint_addrs_pair_t>        checkpoint_addrs_pairs_t;
 
-typedef std::vector<bool>                           path_code_t;
-
 class cond_direct_instruction : public instruction
 {
 public:
@@ -30,8 +30,8 @@ public:
   UINT32 used_rollback_num;
   UINT32 exec_order;
 
-  path_code_t path_code;
-  ptr_uint8_t fresh_input;
+  path_code_id_t path_code;
+  ptr_input_t fresh_input;
 
   addrint_set_t             input_dep_addrs;
   addrint_value_maps_t      first_input_projections;
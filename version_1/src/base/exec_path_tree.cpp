@@ -0,0 +1,77 @@
+#include "exec_path_tree.h"
+
+#include <algorithm>
+#include <boost/unordered_map.hpp>
+
+/*================================================================================================*/
+
+// a node of the tree keeps the first instance of its instruction (instances at the same execution
+// order and address are interchangeable in the calculation of path conditions), children are
+// indexed by their execution orders and addresses
+struct exec_path_node_t
+{
+  exec_node_id_t    parent;
+  UINT32            length;
+  UINT32            exec_order;
+  ptr_instruction_t ins;
+};
+
+typedef std::pair<exec_node_id_t, std::pair<UINT32, ADDRINT>> exec_path_edge_t;
+
+static std::vector<exec_path_node_t> exec_path_nodes(1, exec_path_node_t{ empty_exec_path, 0, 0,
+                                                                          ptr_instruction_t() });
+static boost::unordered_map<exec_path_edge_t, exec_node_id_t> child_at_edge;
+
+/*================================================================================================*/
+
+/**
+ * @brief intern a path, only its CFIs are kept unless all instructions are requested, so memory
+ * grows with the number of distinct CFI instances rather than with the total length of paths
+ */
+auto interned_exec_path (const order_ins_map_t& path, bool all_ins) -> exec_node_id_t
+{
+  auto node = empty_exec_path;
+  std::for_each(path.begin(), path.end(), [&](order_ins_map_t::const_reference order_ins)
+  {
+    if (!all_ins && !order_ins.second->is_cond_direct_cf) return;
+
+    auto edge = std::make_pair(node, std::make_pair(order_ins.first, order_ins.second->address));
+    auto child_iter = child_at_edge.find(edge);
+    if (child_iter == child_at_edge.end())
+    {
+      auto child = static_cast<exec_node_id_t>(exec_path_nodes.size());
+      exec_path_nodes.push_back(exec_path_node_t{ node, exec_path_nodes[node].length + 1,
+                                                  order_ins.first, order_ins.second });
+      child_iter = child_at_edge.insert(std::make_pair(edge, child)).first;
+    }
+    node = child_iter->second;
+  });
+  return node;
+}
+
+
+/**
+ * @brief the kept instructions of a path, indexed by their execution orders
+ */
+auto exec_path_content (exec_node_id_t path) -> order_ins_map_t
+{
+  order_ins_map_t content;
+  for (; path != empty_exec_path; path = exec_path_nodes[path].parent)
+  {
+    content.insert(content.begin(), std::make_pair(exec_path_nodes[path].exec_order,
+                                                    exec_path_nodes[path].ins));
+  }
+  return content;
+}
+
+
+auto exec_path_length (exec_node_id_t path) -> UINT32
+{
+  return exec_path_nodes[path].length;
+}
+
+
+auto exec_path_node_num () -> UINT32
+{
+  return static_cast<UINT32>(exec_path_nodes.size());
+}
@@ -0,0 +1,22 @@
+#ifndef EXEC_PATH_TREE_H
+#define EXEC_PATH_TREE_H
+
+#include "../parsing_helper.h"
+#include "instruction.h"
+
+// an execution path is interned as a node of a tree of executed instructions: the parent of a node
+// is the instruction executed before it in the path, the root (id 0) is the empty path; paths
+// sharing a prefix share its nodes, so a path is identified by its last node
+typedef UINT32                                      exec_node_id_t;
+
+static const exec_node_id_t                         empty_exec_path = 0;
+
+extern auto interned_exec_path  (const order_ins_map_t& path, bool all_ins) -> exec_node_id_t;
+
+extern auto exec_path_content   (exec_node_id_t path)                     -> order_ins_map_t;
+
+extern auto exec_path_length    (exec_node_id_t path)                     -> UINT32;
+
+extern auto exec_path_node_num  ()                                        -> UINT32;
+
+#endif // EXEC_PATH_TREE_H
@@ -1,13 +1,22 @@
 #include "execution_dfa.h"
+#include "value_set_label.h"
 #include "../util/stuffs.h"
+#include "../util/dfa_table.h"
 
 #include <numeric>
+#include <iterator>
 #include <locale>
+#include <set>
+#include <map>
+#include <list>
 #include <boost/graph/graphviz.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <limits>
 
 typedef ptr_cond_direct_inss_t                                dfa_vertex;
 typedef std::vector<dfa_vertex>                               dfa_vertices;
-typedef addrint_value_maps_t                                  dfa_edge;
+typedef std::pair<addrint_value_maps_t, value_set_label>     dfa_edge;
 typedef std::vector<dfa_edge>                                 dfa_edges;
 typedef boost::adjacency_list<boost::listS, boost::vecS,
                               boost::bidirectionalS,
@@ -35,15 +44,29 @@ static dfa_vertex_desc  initial_state;
 
 static ptr_exec_dfa_t   single_dfa_instance;
 
+// the transitions of the raw DFA indexed by their sources and labels, the index is valid only while
+// the DFA is a prefix tree (i.e. until it is pre-processed)
+typedef std::pair<dfa_vertex_desc, value_set_label>           state_label_t;
+static boost::unordered_map<state_label_t, dfa_vertex_desc>   next_state_at_label;
+
 /*================================================================================================*/
 
+/**
+ * @brief a transition keeps its condition with the canonical label of the condition, transitions
+ * are compared by their labels
+ */
+static auto labeled_transition (const addrint_value_maps_t& trans_cond) -> dfa_edge
+{
+  return std::make_pair(trans_cond, value_set_label(trans_cond));
+}
+
 
 auto execution_dfa::instance() -> ptr_exec_dfa_t
 {
   if (!single_dfa_instance)
   {
     single_dfa_instance = std::make_shared<execution_dfa>(construction_key());
-    internal_dfa.clear();
+    internal_dfa.clear(); next_state_at_label.clear();
     initial_state = boost::add_vertex(ptr_cond_direct_inss_t(), internal_dfa);
   }
 
@@ -52,80 +75,73 @@ auto execution_dfa::instance() -> ptr_exec_dfa_t
 
 
 /**
- * @brief execution_dfa::add_exec_paths
+ * @brief execution_dfa::add_exec_path: the path is inserted into the raw DFA (a prefix tree of
+ * path conditions) once it is explored, the next state of each sub-condition is looked up by the
+ * label of the sub-condition
  */
-auto execution_dfa::add_exec_paths (const ptr_exec_paths_t& exec_paths) -> void
+auto execution_dfa::add_exec_path (const ptr_exec_path_t& exec_path) -> void
 {
-  auto add_exec_path = [](ptr_exec_path_t exec_path) -> void
+  auto get_next_state = [](dfa_vertex_desc current_state,
+      const value_set_label& transition_label) -> dfa_vertex_desc
   {
-    auto get_next_state = [](dfa_vertex_desc current_state,
-        const addrint_value_maps_t& transition_cond) -> dfa_vertex_desc
+    if (current_state == boost::graph_traits<dfa_graph_t>::null_vertex())
+      return boost::graph_traits<dfa_graph_t>::null_vertex();
+    else
     {
-      if (current_state == boost::graph_traits<dfa_graph_t>::null_vertex())
-        return boost::graph_traits<dfa_graph_t>::null_vertex();
-      else
-      {
-        /*boost::graph_traits<dfa_graph_t>::out_edge_iterator*/
-//        dfa_out_edge_iter first_trans_iter, last_trans_iter;
-
-        auto first_trans_iter = dfa_out_edge_iter(); auto last_trans_iter = dfa_out_edge_iter();
-        std::tie(first_trans_iter, last_trans_iter) = boost::out_edges(current_state, internal_dfa);
-
-        auto iso_predicate = [&transition_cond](dfa_edge_desc edge) -> bool
-        {
-          return two_vmaps_are_isomorphic(transition_cond, internal_dfa[edge]);
-        };
-
-        auto found_trans_iter = std::find_if(first_trans_iter, last_trans_iter, iso_predicate);
-        return (found_trans_iter == last_trans_iter) ?
-              boost::graph_traits<dfa_graph_t>::null_vertex() :
-              boost::target(*found_trans_iter, internal_dfa);
-      }
-    };
+      auto next_state_iter = next_state_at_label.find(std::make_pair(current_state,
+                                                                     transition_label));
+      return (next_state_iter == std::end(next_state_at_label)) ?
+            boost::graph_traits<dfa_graph_t>::null_vertex() : next_state_iter->second;
+    }
+  };
 
+  // add the execution path into the DFA
+//  tfm::format(std::cerr, "======\nadd a new execution path\n");
+  auto prev_state = initial_state; auto mismatch = false;
+  std::for_each(std::begin(exec_path->condition), std::end(exec_path->condition),
+                [&](decltype(exec_path->condition)::const_reference sub_cond)
+  {
+    // trick: once mismatch is assigned to true then it will be never re-assigned to false
+    auto current_state = boost::graph_traits<dfa_graph_t>::null_vertex();
+    auto transition = labeled_transition(std::get<0>(sub_cond));
+    if (!mismatch)
+    {
+      current_state = get_next_state(prev_state, std::get<1>(transition));
+      mismatch = (current_state == boost::graph_traits<dfa_graph_t>::null_vertex());
+    }
 
-    // add the execution path into the DFA
-  //  tfm::format(std::cerr, "======\nadd a new execution path\n");
-    auto prev_state = initial_state; auto mismatch = false;
-    std::for_each(std::begin(exec_path->condition), std::end(exec_path->condition),
-                  [&](decltype(exec_path->condition)::const_reference sub_cond)
+    if (mismatch)
     {
-      // trick: once mismatch is assigned to true then it will be never re-assigned to false
-//      dfa_vertex_desc current_state;
-      auto current_state = boost::graph_traits<dfa_graph_t>::null_vertex();
-      if (!mismatch)
+      std::for_each(std::begin(std::get<1>(sub_cond)), std::end(std::get<1>(sub_cond)),
+                    [&](ptr_cond_direct_inss_t::const_reference cfi)
       {
-        current_state = get_next_state(prev_state, std::get<0>(sub_cond));
-        mismatch = (current_state == boost::graph_traits<dfa_graph_t>::null_vertex());
-      }
+        if (std::find(std::begin(internal_dfa[prev_state]), std::end(internal_dfa[prev_state]),
+                      cfi) == std::end(internal_dfa[prev_state]))
+          internal_dfa[prev_state].push_back(cfi);
+      });
 
-      if (mismatch)
-      {
-  //      internal_dfa[prev_state] = std::get<1>(sub_cond);
-  //      internal_dfa[prev_state].insert(internal_dfa[prev_state].end(),
-  //                                      std::get<1>(sub_cond).begin(), std::get<1>(sub_cond).end());
-        std::for_each(std::begin(std::get<1>(sub_cond)), std::end(std::get<1>(sub_cond)),
-                      [&](ptr_cond_direct_inss_t::const_reference cfi)
-        {
-          if (std::find(std::begin(internal_dfa[prev_state]), std::end(internal_dfa[prev_state]),
-                        cfi) == std::end(internal_dfa[prev_state]))
-            internal_dfa[prev_state].push_back(cfi);
-        });
+      current_state = boost::add_vertex(ptr_cond_direct_inss_t(), internal_dfa);
+      next_state_at_label.insert(std::make_pair(std::make_pair(prev_state, std::get<1>(transition)),
+                                                current_state));
+      boost::add_edge(prev_state, current_state, transition, internal_dfa);
+    }
 
-        current_state = boost::add_vertex(ptr_cond_direct_inss_t(), internal_dfa);
-        boost::add_edge(prev_state, current_state, std::get<0>(sub_cond), internal_dfa);
-      }
+    prev_state = current_state;
+  });
 
-      prev_state = current_state;
-    });
+  return;
+}
 
-    return;
-  };
 
+/**
+ * @brief execution_dfa::add_exec_paths
+ */
+auto execution_dfa::add_exec_paths (const ptr_exec_paths_t& exec_paths) -> void
+{
   std::for_each(std::begin(exec_paths), std::end(exec_paths),
-                [&](decltype(explored_exec_paths)::const_reference exec_path)
+                [this](ptr_exec_paths_t::const_reference exec_path)
   {
-    add_exec_path(exec_path);
+    this->add_exec_path(exec_path);
   });
   return;
 }
@@ -677,73 +693,290 @@ typedef dfa_vertex_partition_t::iterator    dfa_vertex_partition_iter_t;
 
 
 /**
- * @brief quotient_dfa_from_equivalence
- * @param equiv_partition
+ * @brief state_relation_t: an equivalence of states kept as a union-find (with path compression
+ * and union by size), each root keeps also the states and the order of its class. A merge relates
+ * (by transitivity) the states of a class with the ones of the other, these pairs stay unchecked
+ * until next_unchecked gives them back: first from each state to the merged state of the other
+ * class, then across the classes; the states of the older class come first.
  */
-typedef std::map<dfa_vertex_desc, dfa_vertex_descs> state_states_map_t;
-auto static construct_quotient_dfa_from_equivalence (const state_pairs_t& state_rel) -> void
+class state_relation_t
+{
+public:
+  auto contains       (dfa_vertex_desc state_a, dfa_vertex_desc state_b) const -> bool;
+  auto add            (dfa_vertex_desc state_a, dfa_vertex_desc state_b)       -> void;
+  auto next_unchecked (dfa_vertex_desc& state_a, dfa_vertex_desc& state_b)     -> bool;
+  auto size           () const                                                 -> std::size_t;
+  auto is_identity    () const                                                 -> bool;
+  auto partition      () const                                           -> dfa_vertex_partition_t;
+
+private:
+  typedef boost::unordered_map<dfa_vertex_desc, std::size_t> state_index_map_t;
+
+  struct unchecked_merge_t
+  {
+    dfa_vertex_desc                             state_a;
+    dfa_vertex_desc                             state_b;
+    dfa_vertex_descs                            states_a;
+    dfa_vertex_descs                            states_b;
+    state_index_map_t                           index_a;
+    state_index_map_t                           index_b;
+    std::size_t                                 next_pair;
+    mutable boost::unordered_set<state_pair_t>  checked_pairs;
+  };
+  typedef std::list<unchecked_merge_t>  unchecked_merges_t;
+
+  auto class_of       (dfa_vertex_desc state) const                              -> dfa_vertex_desc;
+  auto merge_of       (dfa_vertex_desc& state_a, dfa_vertex_desc& state_b) const
+                                                      -> unchecked_merges_t::const_iterator;
+  auto pair_at        (const unchecked_merge_t& merge, std::size_t pair_idx) const -> state_pair_t;
+  auto index_of       (const unchecked_merge_t& merge,
+                       dfa_vertex_desc state_a, dfa_vertex_desc state_b) const   -> std::size_t;
+
+  mutable boost::unordered_map<dfa_vertex_desc, dfa_vertex_desc>      root_of_state;
+  boost::unordered_map<dfa_vertex_desc, std::list<dfa_vertex_desc>>   states_of_root;
+  boost::unordered_map<dfa_vertex_desc, std::size_t>                  order_of_root;
+  boost::unordered_map<dfa_vertex_desc, std::size_t>                  age_of_root;
+  unchecked_merges_t                                                  unchecked_merges;
+  std::size_t                                                         class_order = 0;
+  std::size_t                                                         pair_num = 0;
+};
+
+
+auto state_relation_t::class_of (dfa_vertex_desc state) const -> dfa_vertex_desc
+{
+  auto root = state;
+  while (this->root_of_state[root] != root) root = this->root_of_state[root];
+
+  while (state != root)
+  {
+    auto parent = this->root_of_state[state]; this->root_of_state[state] = root; state = parent;
+  }
+  return root;
+}
+
+
+/**
+ * @brief state_relation_t::merge_of: the unchecked merge relating the states by transitivity, the
+ * states are swapped so that a is in the class a of the merge
+ */
+auto state_relation_t::merge_of (dfa_vertex_desc& state_a,
+                                 dfa_vertex_desc& state_b) const
+                                                      -> unchecked_merges_t::const_iterator
 {
-  auto state_partition = [](const state_pairs_t& state_rel) -> dfa_vertex_partition_t
+  return std::find_if(std::begin(this->unchecked_merges), std::end(this->unchecked_merges),
+                      [&](const unchecked_merge_t& merge)
   {
-    auto get_equiv_class = [](dfa_vertex_desc state,
-        dfa_vertex_partition_t& equiv_classes) -> dfa_vertex_partition_iter_t
+    auto is_across = [&merge](dfa_vertex_desc state_x, dfa_vertex_desc state_y) -> bool
     {
-      return std::find_if(std::begin(equiv_classes), std::end(equiv_classes),
-                          [&state](const dfa_vertex_descs& states)
-      {
-        return (std::find(std::begin(states), std::end(states), state) != std::end(states));
-      });
+      return ((merge.index_a.find(state_x) != std::end(merge.index_a)) &&
+              (merge.index_b.find(state_y) != std::end(merge.index_b)));
     };
 
-    auto partition = dfa_vertex_partition_t();
-    std::for_each(std::begin(state_rel), std::end(state_rel), [&](const state_pair_t& state_pair)
+    if (is_across(state_a, state_b)) return true;
+    if (is_across(state_b, state_a))
     {
-      auto state_a = std::get<0>(state_pair); auto state_b = std::get<1>(state_pair);
+      std::swap(state_a, state_b); return true;
+    }
+    return false;
+  });
+}
 
-      auto class_a_iter = get_equiv_class(state_a, partition);
-      auto class_b_iter = get_equiv_class(state_b, partition);
 
-      if ((class_a_iter != std::end(partition)) && (class_b_iter != std::end(partition)))
-      {
-        if (class_a_iter != class_b_iter)
-        {
-          auto class_a = *class_a_iter; auto class_b = *class_b_iter;
+/**
+ * @brief state_relation_t::pair_at: the pairs of a merge of a and b are (x,b) for each x of the
+ * class of a, then (y,a) for each y of the class of b, then (x,y); a pair may be met again later
+ */
+auto state_relation_t::pair_at (const unchecked_merge_t& merge,
+                                std::size_t pair_idx) const -> state_pair_t
+{
+  auto num_a = merge.states_a.size(); auto num_b = merge.states_b.size();
+  if (pair_idx < num_a) return std::make_pair(merge.states_a[pair_idx], merge.state_b);
+  if (pair_idx < num_a + num_b)
+    return std::make_pair(merge.states_b[pair_idx - num_a], merge.state_a);
 
-          tfm::format(std::cerr, "merging a and b\n");
+  pair_idx -= num_a + num_b;
+  return std::make_pair(merge.states_a[pair_idx / num_b], merge.states_b[pair_idx % num_b]);
+}
 
-          // merge two equivalence classes: c = a + b
-          auto class_c = class_a;
-          class_c.insert(std::end(class_c), std::begin(class_b), std::end(class_b));
 
-          // remove a and b
-          partition.erase(std::find(std::begin(partition), std::end(partition), class_a));
-          partition.erase(std::find(std::begin(partition), std::end(partition), class_b));
+/**
+ * @brief state_relation_t::index_of: the first index of the pair (x,y) where x is in the class a
+ */
+auto state_relation_t::index_of (const unchecked_merge_t& merge, dfa_vertex_desc state_a,
+                                 dfa_vertex_desc state_b) const -> std::size_t
+{
+  auto num_a = merge.states_a.size(); auto num_b = merge.states_b.size();
+  if (state_b == merge.state_b) return merge.index_a.at(state_a);
+  if (state_a == merge.state_a) return num_a + merge.index_b.at(state_b);
+  return num_a + num_b + merge.index_a.at(state_a) * num_b + merge.index_b.at(state_b);
+}
 
-          // add c = a + b
-          partition.push_back(class_c);
-        }
-      }
-      else
-      {
-        if ((class_a_iter == std::end(partition)) && (class_b_iter == std::end(partition)))
-        {
-          auto class_ab = dfa_vertex_descs();
-          class_ab.push_back(state_a);
-          if (state_a != state_b) class_ab.push_back(state_b);
 
-          partition.push_back(class_ab);
-        }
-        else
-        {
-          if (class_a_iter != std::end(partition)) class_a_iter->push_back(state_b);
-          else class_b_iter->push_back(state_a);
-        }
-      }
-    });
+auto state_relation_t::contains (dfa_vertex_desc state_a, dfa_vertex_desc state_b) const -> bool
+{
+  if ((this->root_of_state.find(state_a) == std::end(this->root_of_state)) ||
+      (this->root_of_state.find(state_b) == std::end(this->root_of_state))) return false;
+  if (this->class_of(state_a) != this->class_of(state_b)) return false;
+
+  auto merge_iter = this->merge_of(state_a, state_b);
+  if (merge_iter == std::end(this->unchecked_merges)) return true;
 
-    return partition;
+  return ((this->index_of(*merge_iter, state_a, state_b) < merge_iter->next_pair) ||
+          (merge_iter->checked_pairs.find(std::make_pair(state_a, state_b)) !=
+           std::end(merge_iter->checked_pairs)));
+}
+
+
+/**
+ * @brief state_relation_t::add: the pair (a,b) comes with (b,a); it merges the classes of a and b
+ * into a class (where the states of b follow the ones of a) placed after all current classes, but
+ * a state joining a class does not move the class
+ */
+auto state_relation_t::add (dfa_vertex_desc state_a, dfa_vertex_desc state_b) -> void
+{
+  auto add_class = [this](dfa_vertex_desc state) -> dfa_vertex_desc
+  {
+    this->root_of_state[state] = state;
+    this->states_of_root[state] = std::list<dfa_vertex_desc>(1, state);
+    this->order_of_root[state] = this->class_order; this->age_of_root[state] = this->class_order;
+    this->class_order++; this->pair_num++;
+    return state;
   };
 
+  auto a_is_kept = (this->root_of_state.find(state_a) != std::end(this->root_of_state));
+  auto b_is_kept = (this->root_of_state.find(state_b) != std::end(this->root_of_state));
+
+  if (!a_is_kept && !b_is_kept)
+  {
+    add_class(state_a);
+    if (state_b != state_a)
+    {
+      this->root_of_state[state_b] = state_a; this->states_of_root[state_a].push_back(state_b);
+      this->pair_num += 3;
+    }
+    return;
+  }
+
+  auto root_a = a_is_kept ? this->class_of(state_a) : add_class(state_a);
+  auto root_b = b_is_kept ? this->class_of(state_b) : add_class(state_b);
+  if (root_a == root_b)
+  {
+    // the pair is related already by an unchecked merge
+    auto merge_iter = this->merge_of(state_a, state_b);
+    if (merge_iter != std::end(this->unchecked_merges))
+      merge_iter->checked_pairs.insert(std::make_pair(state_a, state_b));
+    return;
+  }
+
+  auto& states_a = this->states_of_root[root_a]; auto& states_b = this->states_of_root[root_b];
+  this->pair_num += 2 * states_a.size() * states_b.size();
+
+  auto merge = unchecked_merge_t();
+  auto a_is_older = (this->age_of_root[root_a] < this->age_of_root[root_b]);
+  merge.state_a = a_is_older ? state_a : state_b; merge.state_b = a_is_older ? state_b : state_a;
+  const auto& older_states = a_is_older ? states_a : states_b;
+  const auto& younger_states = a_is_older ? states_b : states_a;
+  merge.states_a.assign(std::begin(older_states), std::end(older_states));
+  merge.states_b.assign(std::begin(younger_states), std::end(younger_states));
+  for (auto idx = std::size_t(0); idx < merge.states_a.size(); ++idx)
+    merge.index_a[merge.states_a[idx]] = idx;
+  for (auto idx = std::size_t(0); idx < merge.states_b.size(); ++idx)
+    merge.index_b[merge.states_b[idx]] = idx;
+  merge.next_pair = 0; merge.checked_pairs.insert(std::make_pair(merge.state_a, merge.state_b));
+  this->unchecked_merges.push_back(std::move(merge));
+
+  auto order = !a_is_kept ? this->order_of_root[root_b] :
+                            !b_is_kept ? this->order_of_root[root_a] : this->class_order++;
+  auto age = std::min(this->age_of_root[root_a], this->age_of_root[root_b]);
+
+  // the smaller class goes under the root of the larger one
+  auto root = (states_a.size() < states_b.size()) ? root_b : root_a;
+  auto child = (root == root_a) ? root_b : root_a;
+  auto& merged_states = a_is_kept ? states_a : states_b;
+  merged_states.splice(std::end(merged_states), a_is_kept ? states_b : states_a);
+  if (&merged_states != &this->states_of_root[root]) this->states_of_root[root].swap(merged_states);
+
+  this->root_of_state[child] = root;
+  this->states_of_root.erase(child);
+  this->order_of_root.erase(child); this->age_of_root.erase(child);
+  this->order_of_root[root] = order; this->age_of_root[root] = age;
+  return;
+}
+
+
+/**
+ * @brief state_relation_t::next_unchecked: the first unchecked pair of the oldest unchecked merge
+ */
+auto state_relation_t::next_unchecked (dfa_vertex_desc& state_a, dfa_vertex_desc& state_b) -> bool
+{
+  while (!this->unchecked_merges.empty())
+  {
+    auto& merge = this->unchecked_merges.front();
+    auto pair_num = merge.states_a.size() * (merge.states_b.size() + 1) + merge.states_b.size();
+    for (; merge.next_pair < pair_num; ++merge.next_pair)
+    {
+      auto state_pair = this->pair_at(merge, merge.next_pair);
+      auto state_x = std::get<0>(state_pair); auto state_y = std::get<1>(state_pair);
+      if (merge.index_a.find(state_x) == std::end(merge.index_a)) std::swap(state_x, state_y);
+
+      if ((this->index_of(merge, state_x, state_y) == merge.next_pair) &&
+          (merge.checked_pairs.erase(std::make_pair(state_x, state_y)) == 0))
+      {
+        std::tie(state_a, state_b) = state_pair; return true;
+      }
+    }
+    this->unchecked_merges.pop_front();
+  }
+  return false;
+}
+
+
+/**
+ * @brief state_relation_t::size: the number of pairs of the relation
+ */
+auto state_relation_t::size () const -> std::size_t
+{
+  return this->pair_num;
+}
+
+
+auto state_relation_t::is_identity () const -> bool
+{
+  return (this->pair_num == this->root_of_state.size());
+}
+
+
+/**
+ * @brief state_relation_t::partition: the classes of the states of the relation in their orders
+ */
+auto state_relation_t::partition () const -> dfa_vertex_partition_t
+{
+  auto root_at_order = std::map<std::size_t, dfa_vertex_desc>();
+  std::for_each(std::begin(this->order_of_root), std::end(this->order_of_root),
+                [&](boost::unordered_map<dfa_vertex_desc, std::size_t>::const_reference root_order)
+  {
+    root_at_order[std::get<1>(root_order)] = std::get<0>(root_order);
+  });
+
+  auto state_partition = dfa_vertex_partition_t();
+  std::for_each(std::begin(root_at_order), std::end(root_at_order),
+                [&](std::map<std::size_t, dfa_vertex_desc>::const_reference order_root)
+  {
+    const auto& class_states = this->states_of_root.at(std::get<1>(order_root));
+    state_partition.push_back(dfa_vertex_descs(std::begin(class_states), std::end(class_states)));
+  });
+
+  return state_partition;
+}
+
+
+/**
+ * @brief quotient_dfa_from_partition
+ * @param partition: every state is in exactly one class
+ */
+typedef std::map<dfa_vertex_desc, dfa_vertex_descs> state_states_map_t;
+static auto construct_quotient_dfa_from_partition (const dfa_vertex_partition_t& partition) -> void
+{
   auto add_representatives = [](const dfa_vertex_partition_t& state_parts) -> state_states_map_t
   {
     auto merge_state_contents =
@@ -802,32 +1035,37 @@ auto static construct_quotient_dfa_from_equivalence (const state_pairs_t& state_
 
   auto add_transitions = [](const state_states_map_t& rep_equivs) -> void
   {
+    // the representative (and the size of the class) of each state
+    auto rep_of_state = std::map<dfa_vertex_desc, state_states_map_t::const_iterator>();
+    for (auto rep_equiv_iter = std::begin(rep_equivs); rep_equiv_iter != std::end(rep_equivs);
+         ++rep_equiv_iter)
+    {
+      std::for_each(std::begin(rep_equiv_iter->second), std::end(rep_equiv_iter->second),
+                    [&](dfa_vertex_desc state)
+      {
+        rep_of_state[state] = rep_equiv_iter;
+      });
+    }
+
     std::for_each(std::begin(rep_equivs), std::end(rep_equivs),
                   [&](state_states_map_t::const_reference rep_equiv_a)
     {
-      auto rep_a = std::get<0>(rep_equiv_a); auto equiv_a = std::get<1>(rep_equiv_a);
+      auto rep_a = std::get<0>(rep_equiv_a); const auto& equiv_a = std::get<1>(rep_equiv_a);
 
-      std::for_each(std::begin(rep_equivs), std::end(rep_equivs),
-                    [&](state_states_map_t::const_reference rep_equiv_b)
+      std::for_each(std::begin(equiv_a), std::end(equiv_a), [&](dfa_vertex_desc state_a)
       {
-        auto rep_b = std::get<0>(rep_equiv_b); auto equiv_b = std::get<1>(rep_equiv_b);
-
-        if ((equiv_a.size() > 1) || (equiv_b.size() > 1))
+        auto first_trans_iter = dfa_out_edge_iter(); auto last_trans_iter = dfa_out_edge_iter();
+        std::tie(first_trans_iter, last_trans_iter) = boost::out_edges(state_a, internal_dfa);
+        std::for_each(first_trans_iter, last_trans_iter, [&](dfa_edge_desc trans_from_a)
         {
-          std::for_each(std::begin(equiv_a), std::end(equiv_a), [&](dfa_vertex_desc state_a)
+          auto rep_b_iter = rep_of_state.find(boost::target(trans_from_a, internal_dfa));
+          if ((rep_b_iter != std::end(rep_of_state)) &&
+              ((equiv_a.size() > 1) || (rep_b_iter->second->second.size() > 1)))
           {
-            auto first_trans_iter = dfa_out_edge_iter(); auto last_trans_iter = dfa_out_edge_iter();
-            std::tie(first_trans_iter, last_trans_iter) = boost::out_edges(state_a, internal_dfa);
-            std::for_each(first_trans_iter, last_trans_iter, [&](dfa_edge_desc trans_from_a)
-            {
-              if (std::find(std::begin(equiv_b), std::end(equiv_b),
-                            boost::target(trans_from_a, internal_dfa)) != std::end(equiv_b))
-              {
-                boost::add_edge(rep_a, rep_b, internal_dfa[trans_from_a], internal_dfa);
-              }
-            });
-          });
-        }
+            boost::add_edge(rep_a, rep_b_iter->second->first, internal_dfa[trans_from_a],
+                            internal_dfa);
+          }
+        });
       });
     });
 
@@ -857,7 +1095,8 @@ auto static construct_quotient_dfa_from_equivalence (const state_pairs_t& state_
           {
             return ((boost::target(*trans_iter, internal_dfa) ==
                      boost::target(next_trans, internal_dfa)) &&
-                    (two_vmaps_are_isomorphic(internal_dfa[*trans_iter], internal_dfa[next_trans])));
+                    (std::get<1>(internal_dfa[*trans_iter]) ==
+                     std::get<1>(internal_dfa[next_trans])));
           }) != last_trans_iter;
 
           if (duplicated_trans_exists)
@@ -875,26 +1114,21 @@ auto static construct_quotient_dfa_from_equivalence (const state_pairs_t& state_
 
   auto erase_redundant_states = [](const state_states_map_t& rep_equivs) -> void
   {
-    auto redundant_states = dfa_vertex_descs();
+    auto redundant_states = std::set<dfa_vertex_desc>();
     std::for_each(std::begin(rep_equivs), std::end(rep_equivs),
                   [&](state_states_map_t::const_reference state_equiv)
     {
-      auto equiv_states = std::get<1>(state_equiv);
+      const auto& equiv_states = std::get<1>(state_equiv);
       if (equiv_states.size() > 1)
-      {
-        std::for_each(std::begin(equiv_states), std::end(equiv_states), [&](dfa_vertex_desc state)
-        {
-          redundant_states.push_back(state);
-        });
-      }
+        redundant_states.insert(std::begin(equiv_states), std::end(equiv_states));
     });
 
     boost::remove_edge_if([&](dfa_edge_desc trans)
     {
-      return ((std::find(std::begin(redundant_states), std::end(redundant_states),
-                        boost::target(trans, internal_dfa)) != std::end(redundant_states)) ||
-              (std::find(std::begin(redundant_states), std::end(redundant_states),
-                         boost::source(trans, internal_dfa)) != std::end(redundant_states)));
+      return ((redundant_states.find(boost::target(trans, internal_dfa)) !=
+               std::end(redundant_states)) ||
+              (redundant_states.find(boost::source(trans, internal_dfa)) !=
+               std::end(redundant_states)));
     }, internal_dfa);
 
     auto isolated_state_exists = true;
@@ -918,7 +1152,6 @@ auto static construct_quotient_dfa_from_equivalence (const state_pairs_t& state_
   }; // end of erase_redundant_states lambda
 
   //==== function starts here
-  auto partition = state_partition(state_rel);
   auto representative_classes = add_representatives(partition);
   add_transitions(representative_classes);
   erase_duplicated_transitions(representative_classes);
@@ -929,70 +1162,178 @@ auto static construct_quotient_dfa_from_equivalence (const state_pairs_t& state_
 
 
 /**
- * @brief check_equivalence
- * @param equiv_rel
- * @param state_a
- * @param state_b
+ * @brief minimal_equivalence_partition: the coarsest partition of states where equivalent states
+ * have transitions of the same labels into equivalent states, computed by Hopcroft's partition
+ * refinement: a block splits the others by the predecessors of its states, and only the smaller
+ * half of a split block is scanned and queued as a splitter, so the refinement runs in O(n log n).
+ * States without CFI are not merged.
  * @return
  */
-static auto check_equivalence (state_pairs_t& equiv_rel,
-                               dfa_vertex_desc state_a, dfa_vertex_desc state_b) -> bool
+static auto minimal_equivalence_partition () -> dfa_vertex_partition_t
 {
-  if (std::find(std::begin(equiv_rel), std::end(equiv_rel),
-                std::make_pair(state_a, state_b)) != std::end(equiv_rel)) return true;
-  else
+  typedef std::pair<UINT32, dfa_vertex_desc>  label_state_t;
+  typedef std::pair<UINT32, UINT32>           block_label_t;
+
+  auto state_num = boost::num_vertices(internal_dfa);
+
+  // intern canonical labels, then index transitions by their sources and by their labels and targets
+  auto label_id_of = boost::unordered_map<value_set_label, UINT32>();
+  auto labels_of_state = std::vector<std::vector<UINT32>>(state_num);
+  auto in_labels_of_state = std::vector<std::vector<UINT32>>(state_num);
+  auto sources_of = boost::unordered_map<label_state_t, dfa_vertex_descs>();
+
+  auto first_trans_iter = dfa_edge_iter(); auto last_trans_iter = dfa_edge_iter();
+  std::tie(first_trans_iter, last_trans_iter) = boost::edges(internal_dfa);
+  std::for_each(first_trans_iter, last_trans_iter, [&](dfa_edge_desc trans)
+  {
+    auto label_id = label_id_of.insert(
+          std::make_pair(std::get<1>(internal_dfa[trans]),
+                         static_cast<UINT32>(label_id_of.size()))).first->second;
+    labels_of_state[boost::source(trans, internal_dfa)].push_back(label_id);
+    in_labels_of_state[boost::target(trans, internal_dfa)].push_back(label_id);
+    sources_of[std::make_pair(label_id, boost::target(trans, internal_dfa))].push_back(
+          boost::source(trans, internal_dfa));
+  });
+
+  // initial partition: states of the same labels (with multiplicity) are in the same block
+  auto blocks = dfa_vertex_partition_t();
+  auto block_of = std::vector<UINT32>(state_num);
+  auto position_of = std::vector<std::size_t>(state_num);
+  auto block_of_labels = std::map<std::vector<UINT32>, UINT32>();
+
+  auto add_to_block = [&](dfa_vertex_desc state, UINT32 block) -> void
+  {
+    block_of[state] = block; position_of[state] = blocks[block].size();
+    blocks[block].push_back(state);
+  };
+
+  auto first_state_iter = dfa_vertex_iter(); auto last_state_iter = dfa_vertex_iter();
+  std::tie(first_state_iter, last_state_iter) = boost::vertices(internal_dfa);
+  std::for_each(first_state_iter, last_state_iter, [&](dfa_vertex_desc state)
   {
-    if (state_a == state_b)
+    std::sort(std::begin(labels_of_state[state]), std::end(labels_of_state[state]));
+    if (internal_dfa[state].empty())
     {
-      equiv_rel.push_back(std::make_pair(state_a, state_b));
-      return true;
+      blocks.push_back(dfa_vertex_descs()); add_to_block(state, blocks.size() - 1);
     }
     else
     {
-      if (boost::out_degree(state_a, internal_dfa) == boost::out_degree(state_b, internal_dfa))
+      auto block_iter = block_of_labels.find(labels_of_state[state]);
+      if (block_iter == std::end(block_of_labels))
       {
-        auto first_trans_a_iter = dfa_out_edge_iter();
-        auto last_trans_a_iter = dfa_out_edge_iter();
-        std::tie(first_trans_a_iter, last_trans_a_iter) = boost::out_edges(state_a,
-                                                                           internal_dfa);
+        blocks.push_back(dfa_vertex_descs());
+        block_iter = block_of_labels.insert(
+              std::make_pair(labels_of_state[state], static_cast<UINT32>(blocks.size() - 1))).first;
+      }
+      add_to_block(state, block_iter->second);
+    }
+  });
+
+  // a block splits others only by the labels of transitions into its states
+  auto in_labels_of_block = [&](UINT32 block) -> std::vector<UINT32>
+  {
+    auto block_labels = std::vector<UINT32>();
+    std::for_each(std::begin(blocks[block]), std::end(blocks[block]), [&](dfa_vertex_desc state)
+    {
+      block_labels.insert(std::end(block_labels), std::begin(in_labels_of_state[state]),
+                          std::end(in_labels_of_state[state]));
+    });
+    std::sort(std::begin(block_labels), std::end(block_labels));
+    block_labels.erase(std::unique(std::begin(block_labels), std::end(block_labels)),
+                       std::end(block_labels));
+    return block_labels;
+  };
+
+  auto splitters = std::vector<block_label_t>();
+  auto waiting_splitters = std::set<block_label_t>();
+  auto add_splitter = [&](UINT32 block, UINT32 label) -> void
+  {
+    if (waiting_splitters.insert(std::make_pair(block, label)).second)
+      splitters.push_back(std::make_pair(block, label));
+  };
 
-        auto first_trans_b_iter = dfa_out_edge_iter();
-        auto last_trans_b_iter = dfa_out_edge_iter();
-        std::tie(first_trans_b_iter, last_trans_b_iter) = boost::out_edges(state_b,
-                                                                           internal_dfa);
+  for (UINT32 block = 0; block < blocks.size(); ++block)
+  {
+    auto block_labels = in_labels_of_block(block);
+    std::for_each(std::begin(block_labels), std::end(block_labels), [&](UINT32 label)
+    {
+      add_splitter(block, label);
+    });
+  }
+
+  auto state_is_marked = std::vector<bool>(state_num, false);
+  while (!splitters.empty())
+  {
+    auto splitter = splitters.back(); splitters.pop_back(); waiting_splitters.erase(splitter);
+    auto splitter_label = std::get<1>(splitter);
 
-        if (std::all_of(first_trans_a_iter, last_trans_a_iter, [&](dfa_edge_desc trans_a)
+    // the predecessors by the label of the states of the splitter, grouped by their blocks
+    auto marked_states_of_block = std::map<UINT32, dfa_vertex_descs>();
+    auto splitter_states = blocks[std::get<0>(splitter)];
+    std::for_each(std::begin(splitter_states), std::end(splitter_states), [&](dfa_vertex_desc state)
+    {
+      auto sources_iter = sources_of.find(std::make_pair(splitter_label, state));
+      if (sources_iter != std::end(sources_of))
+      {
+        std::for_each(std::begin(sources_iter->second), std::end(sources_iter->second),
+                      [&](dfa_vertex_desc source)
         {
-          return std::any_of(first_trans_b_iter, last_trans_b_iter, [&](dfa_edge_desc trans_b)
+          if (!state_is_marked[source])
           {
-            return two_vmaps_are_isomorphic(internal_dfa[trans_a], internal_dfa[trans_b]);
-          });
-        }))
-        {
-          equiv_rel.push_back(std::make_pair(state_a, state_b));
-          equiv_rel.push_back(std::make_pair(state_b, state_a));
+            state_is_marked[source] = true; marked_states_of_block[block_of[source]].push_back(source);
+          }
+        });
+      }
+    });
 
-          return std::all_of(first_trans_a_iter, last_trans_a_iter,
-                             [&](dfa_edge_desc trans_a) -> bool
-          {
-            auto corresponding_trans_iter = std::find_if(first_trans_b_iter, last_trans_b_iter,
-                                                         [&](dfa_edge_desc trans_b)
-            {
-              return two_vmaps_are_isomorphic(internal_dfa[trans_a], internal_dfa[trans_b]);
-            });
+    // split each block having both marked and unmarked states
+    std::for_each(std::begin(marked_states_of_block), std::end(marked_states_of_block),
+                  [&](std::map<UINT32, dfa_vertex_descs>::const_reference block_marked_states)
+    {
+      auto split_block = std::get<0>(block_marked_states);
+      const auto& marked_states = std::get<1>(block_marked_states);
 
-            if (corresponding_trans_iter != last_trans_b_iter)
-              return check_equivalence(equiv_rel, boost::target(trans_a, internal_dfa),
-                                       boost::target(*corresponding_trans_iter, internal_dfa));
-            else return false;
-          });
-        }
-        else return false;
+      // the smaller half of the split block (the marked states or the others) is moved
+      auto moved_states = dfa_vertex_descs();
+      if (marked_states.size() < blocks[split_block].size())
+      {
+        if (2 * marked_states.size() <= blocks[split_block].size()) moved_states = marked_states;
+        else std::copy_if(std::begin(blocks[split_block]), std::end(blocks[split_block]),
+                          std::back_inserter(moved_states),
+                          [&](dfa_vertex_desc state) { return !state_is_marked[state]; });
       }
-      else return false;
-    }
+
+      std::for_each(std::begin(marked_states), std::end(marked_states), [&](dfa_vertex_desc state)
+      {
+        state_is_marked[state] = false;
+      });
+
+      if (!moved_states.empty())
+      {
+        auto new_block = static_cast<UINT32>(blocks.size()); blocks.push_back(dfa_vertex_descs());
+        std::for_each(std::begin(moved_states), std::end(moved_states), [&](dfa_vertex_desc state)
+        {
+          auto last_state = blocks[split_block].back();
+          blocks[split_block][position_of[state]] = last_state;
+          position_of[last_state] = position_of[state];
+          blocks[split_block].pop_back();
+          add_to_block(state, new_block);
+        });
+
+        // the new (smaller) block becomes a splitter for each label of transitions into it: a
+        // waiting splitter of the split block keeps the other half, otherwise the other half is
+        // not needed
+        auto block_labels = in_labels_of_block(new_block);
+        std::for_each(std::begin(block_labels), std::end(block_labels), [&](UINT32 label)
+        {
+          add_splitter(new_block, label);
+        });
+      }
+    });
   }
-}; // end of check_equivalence
+
+  return blocks;
+}
 
 
 /**
@@ -1030,160 +1371,148 @@ static auto check_equivalence (state_pairs_t& equiv_rel,
 //}
 
 
-/**
- * @brief check_approximation
- * @param equiv_rel
- * @param state_a
- * @param state_b
- * @return
- */
-static auto check_approximation (state_pairs_t& equiv_rel,
-                                 dfa_vertex_desc state_a, dfa_vertex_desc state_b) -> bool
+//==== state comparison functions
+static auto are_identical (dfa_vertex_desc state_a, dfa_vertex_desc state_b) -> bool
 {
-  auto is_not_transitive = [](const state_pairs_t& rel,
-      dfa_vertex_desc& state_a, dfa_vertex_desc& state_b) -> bool
-  {
-    return std::any_of(std::begin(rel), std::end(rel),
-                                  [&](const state_pair_t& pair_a)
-    {
-      auto s1_a = std::get<1>(pair_a);
-      return std::any_of(std::begin(rel), std::end(rel), [&](const state_pair_t& pair_b)
-      {
-        if (s1_a == std::get<0>(pair_b))
-        {
-          state_a = std::get<0>(pair_a); state_b = std::get<1>(pair_b);
-          return std::find(std::begin(rel), std::end(rel),
-                           std::make_pair(state_a, state_b)) == std::end(rel);
-        }
-        else return false;
-      });
-    });
-  }; // end of is_not_transitive lambda
+  return (state_a == state_b);
+}
 
-  //==== state comparison functions
-  auto are_identical = [](dfa_vertex_desc state_a, dfa_vertex_desc state_b) -> bool
-  {
-    return (state_a == state_b);
-  };
 
-  auto one_is_least = [](dfa_vertex_desc state_a, dfa_vertex_desc state_b) -> bool
-  {
-    return (internal_dfa[state_a].empty() || internal_dfa[state_b].empty() ||
-            boost::out_degree(state_a, internal_dfa) == 0 ||
-            boost::out_degree(state_b, internal_dfa) == 0);
-  };
+static auto one_is_least (dfa_vertex_desc state_a, dfa_vertex_desc state_b) -> bool
+{
+  return (internal_dfa[state_a].empty() || internal_dfa[state_b].empty() ||
+          boost::out_degree(state_a, internal_dfa) == 0 ||
+          boost::out_degree(state_b, internal_dfa) == 0);
+}
 
-  auto are_isomorphic = [](dfa_vertex_desc state_a, dfa_vertex_desc state_b) -> bool
+
+static auto are_isomorphic (dfa_vertex_desc state_a, dfa_vertex_desc state_b) -> bool
+{
+  if (!internal_dfa[state_a].empty() && !internal_dfa[state_b].empty())
   {
-    if (!internal_dfa[state_a].empty() && !internal_dfa[state_b].empty())
-    {
-      auto first_trans_a_iter = dfa_out_edge_iter();
-      auto last_trans_a_iter = dfa_out_edge_iter();
-      std::tie(first_trans_a_iter, last_trans_a_iter) = boost::out_edges(state_a, internal_dfa);
+    auto first_trans_a_iter = dfa_out_edge_iter();
+    auto last_trans_a_iter = dfa_out_edge_iter();
+    std::tie(first_trans_a_iter, last_trans_a_iter) = boost::out_edges(state_a, internal_dfa);
 
-      auto first_trans_b_iter = dfa_out_edge_iter();
-      auto last_trans_b_iter = dfa_out_edge_iter();
-      std::tie(first_trans_b_iter, last_trans_b_iter) = boost::out_edges(state_b, internal_dfa);
+    auto first_trans_b_iter = dfa_out_edge_iter();
+    auto last_trans_b_iter = dfa_out_edge_iter();
+    std::tie(first_trans_b_iter, last_trans_b_iter) = boost::out_edges(state_b, internal_dfa);
 
-      return std::all_of(first_trans_a_iter, last_trans_a_iter, [&](dfa_edge_desc trans_a)
+    return std::all_of(first_trans_a_iter, last_trans_a_iter, [&](dfa_edge_desc trans_a)
+    {
+      return std::any_of(first_trans_b_iter, last_trans_b_iter, [&](dfa_edge_desc trans_b)
       {
-        return std::any_of(first_trans_b_iter, last_trans_b_iter, [&](dfa_edge_desc trans_b)
-        {
-          return two_vmaps_are_isomorphic(internal_dfa[trans_a], internal_dfa[trans_b]);
-        });
+        return (std::get<1>(internal_dfa[trans_a]) == std::get<1>(internal_dfa[trans_b]));
       });
-    }
-    else return false;
-  };
+    });
+  }
+  else return false;
+}
 
-  //==== function starts here
-  if (std::find(std::begin(equiv_rel), std::end(equiv_rel),
-                std::make_pair(state_a, state_b)) == std::end(equiv_rel))
+
+/**
+ * @brief check_approximation
+ * @param equiv_rel
+ * @param state_a
+ * @param state_b
+ * @return
+ */
+static auto check_approximation (state_relation_t& equiv_rel,
+                                 dfa_vertex_desc state_a, dfa_vertex_desc state_b) -> bool
+{
+  //==== function starts here, a pair left unchecked by a merge is checked next
+  while (true)
   {
-    if (are_identical(state_a, state_b)) equiv_rel.push_back(std::make_pair(state_a, state_b));
-    else
+    if (!equiv_rel.contains(state_a, state_b))
     {
-      auto ab_isomorphic = are_isomorphic(state_a, state_b);
-      auto a_or_b_unknown = one_is_least(state_a, state_b);
-
-      if (a_or_b_unknown || ab_isomorphic)
+      if (are_identical(state_a, state_b)) equiv_rel.add(state_a, state_b);
+      else
       {
-        equiv_rel.push_back(std::make_pair(state_a, state_b));
-        equiv_rel.push_back(std::make_pair(state_b, state_a));
+        auto ab_isomorphic = are_isomorphic(state_a, state_b);
+        auto a_or_b_unknown = one_is_least(state_a, state_b);
 
-        if (ab_isomorphic)
+        if (a_or_b_unknown || ab_isomorphic)
         {
-          auto first_trans_a_iter = dfa_out_edge_iter();
-          auto last_trans_a_iter = dfa_out_edge_iter();
-          std::tie(first_trans_a_iter, last_trans_a_iter) = boost::out_edges(state_a, internal_dfa);
+          equiv_rel.add(state_a, state_b);
 
-          auto first_trans_b_iter = dfa_out_edge_iter();
-          auto last_trans_b_iter = dfa_out_edge_iter();
-          std::tie(first_trans_b_iter, last_trans_b_iter) = boost::out_edges(state_b, internal_dfa);
-
-          if (!std::all_of(first_trans_a_iter, last_trans_a_iter, [&](dfa_edge_desc trans_a)
+          if (ab_isomorphic)
           {
-            return std::any_of(first_trans_b_iter, last_trans_b_iter, [&](dfa_edge_desc trans_b)
+            auto first_trans_a_iter = dfa_out_edge_iter();
+            auto last_trans_a_iter = dfa_out_edge_iter();
+            std::tie(first_trans_a_iter, last_trans_a_iter) = boost::out_edges(state_a, internal_dfa);
+
+            auto first_trans_b_iter = dfa_out_edge_iter();
+            auto last_trans_b_iter = dfa_out_edge_iter();
+            std::tie(first_trans_b_iter, last_trans_b_iter) = boost::out_edges(state_b, internal_dfa);
+
+            if (!std::all_of(first_trans_a_iter, last_trans_a_iter, [&](dfa_edge_desc trans_a)
             {
-              if (two_vmaps_are_isomorphic(internal_dfa[trans_a], internal_dfa[trans_b]))
-                return check_approximation(equiv_rel, boost::target(trans_a, internal_dfa),
-                                           boost::target(trans_b, internal_dfa));
-              else return false;
-            });
-          })) return false;
+              return std::any_of(first_trans_b_iter, last_trans_b_iter, [&](dfa_edge_desc trans_b)
+              {
+                if (std::get<1>(internal_dfa[trans_a]) == std::get<1>(internal_dfa[trans_b]))
+                  return check_approximation(equiv_rel, boost::target(trans_a, internal_dfa),
+                                             boost::target(trans_b, internal_dfa));
+                else return false;
+              });
+            })) return false;
+          }
         }
+        else return false;
       }
-      else return false;
     }
-  }
 
-  auto next_state_a = dfa_vertex_desc(); auto next_state_b = dfa_vertex_desc();
-  if (is_not_transitive(equiv_rel, next_state_a, next_state_b))
-    return check_approximation(equiv_rel, next_state_a, next_state_b);
-  else return true;
+    if (!equiv_rel.next_unchecked(state_a, state_b)) return true;
+  }
 }
 
 /**
  * @brief natural_approximation
  * @return
  */
-static auto natural_approximation () -> state_pairs_t
+static auto natural_approximation () -> state_relation_t
 {
   auto first_vertex_iter = dfa_vertex_iter(); auto last_vertex_iter = dfa_vertex_iter();
   std::tie(first_vertex_iter, last_vertex_iter) = boost::vertices(internal_dfa);
 
-  auto equiv_rels = std::vector<state_pairs_t>(); auto local_equiv_rel = state_pairs_t();
+  // a relation is checked from each pair which is not in an earlier one. The pair (a,a) relates
+  // only a, it is never larger than the first relation (checked from the first pair (a,a)) so it
+  // is not checked again; a pair neither least nor isomorphic is not related.
+  auto equiv_rels = std::vector<state_relation_t>(); auto local_equiv_rel = state_relation_t();
   std::for_each(first_vertex_iter, last_vertex_iter, [&](dfa_vertex_desc state_a)
   {
     std::for_each(first_vertex_iter, last_vertex_iter, [&](dfa_vertex_desc state_b)
     {
-      if (!internal_dfa[state_a].empty() && !internal_dfa[state_b].empty())
+      if (!internal_dfa[state_a].empty() && !internal_dfa[state_b].empty() &&
+          (are_identical(state_a, state_b) ? equiv_rels.empty() :
+                                             (one_is_least(state_a, state_b) ||
+                                              are_isomorphic(state_a, state_b))))
       {
         if (!std::any_of(std::begin(equiv_rels), std::end(equiv_rels),
-                        [&](const state_pairs_t equiv_rel)
+                         [&](const state_relation_t& equiv_rel)
         {
-          return std::find(std::begin(equiv_rel), std::end(equiv_rel),
-                           std::make_pair(state_a, state_b)) != std::end(equiv_rel);
+          return equiv_rel.contains(state_a, state_b);
         }))
         {
-          local_equiv_rel.clear();
+          local_equiv_rel = state_relation_t();
           if (check_approximation(local_equiv_rel, state_a, state_b))
-            equiv_rels.push_back(local_equiv_rel);
+            equiv_rels.push_back(std::move(local_equiv_rel));
         }
       }
     });
   });
 
-  local_equiv_rel = *std::max_element(std::begin(equiv_rels), std::end(equiv_rels),
-                          [&](const state_pairs_t& equiv_rel_a, const state_pairs_t& equiv_rel_b)
+  if (!equiv_rels.empty())
   {
-    return equiv_rel_a.size() < equiv_rel_b.size();
-  });
+    local_equiv_rel = *std::max_element(std::begin(equiv_rels), std::end(equiv_rels),
+                                        [&](const state_relation_t& equiv_rel_a,
+                                            const state_relation_t& equiv_rel_b)
+    {
+      return equiv_rel_a.size() < equiv_rel_b.size();
+    });
+  }
   std::for_each(first_vertex_iter, last_vertex_iter, [&](dfa_vertex_desc state)
   {
-    if (std::find(std::begin(local_equiv_rel), std::end(local_equiv_rel),
-                  std::make_pair(state, state)) == std::end(local_equiv_rel))
-      local_equiv_rel.push_back(std::make_pair(state, state));
+    if (!local_equiv_rel.contains(state, state)) local_equiv_rel.add(state, state);
   });
 
   return local_equiv_rel;
@@ -1225,29 +1554,35 @@ static auto natural_approximation () -> state_pairs_t
  * @brief natural_unification
  * @return
  */
-static auto natural_unification () -> state_pairs_t
+static auto natural_unification () -> dfa_vertex_partition_t
 {
-  auto equiv_rel = state_pairs_t();
-
   auto first_vertex_iter = dfa_vertex_iter(); auto last_vertex_iter = dfa_vertex_iter();
   std::tie(first_vertex_iter, last_vertex_iter) = boost::vertices(internal_dfa);
 
-  std::for_each(first_vertex_iter, last_vertex_iter, [&](dfa_vertex_desc state_a)
+  // all states without CFI are unified, their class takes the place of the first one
+  auto state_partition = dfa_vertex_partition_t(); auto empty_class_idx = std::size_t(0);
+  auto empty_class_exists = false;
+  std::for_each(first_vertex_iter, last_vertex_iter, [&](dfa_vertex_desc state)
   {
-    std::for_each(first_vertex_iter, last_vertex_iter, [&](dfa_vertex_desc state_b)
+    if (!internal_dfa[state].empty()) state_partition.push_back(dfa_vertex_descs(1, state));
+    else
     {
-      if ((state_a == state_b) || (internal_dfa[state_a].empty() && internal_dfa[state_b].empty()))
+      if (!empty_class_exists)
       {
-        equiv_rel.push_back(std::make_pair(state_a, state_b));
+        empty_class_idx = state_partition.size(); empty_class_exists = true;
+        state_partition.push_back(dfa_vertex_descs());
       }
-    });
+      state_partition[empty_class_idx].push_back(state);
+    }
   });
 
-  return equiv_rel;
+  return state_partition;
 }
 
 auto execution_dfa::pre_processing () -> void
 {
+  next_state_at_label.clear();
+
   auto first_vertex_iter = dfa_vertex_iter(); auto last_vertex_iter = dfa_vertex_iter();
   std::tie(first_vertex_iter, last_vertex_iter) = boost::vertices(internal_dfa);
 
@@ -1262,8 +1597,9 @@ auto execution_dfa::pre_processing () -> void
         if (std::any_of(first_trans_iter, last_trans_iter, [](dfa_edge_desc trans)
         {
           auto to_terminal = internal_dfa[boost::target(trans, internal_dfa)].empty();
-          auto cond_size = internal_dfa[trans].size();
-          auto lack_of_CR = std::none_of(internal_dfa[trans].begin(), internal_dfa[trans].end(),
+          auto cond_size = std::get<0>(internal_dfa[trans]).size();
+          auto lack_of_CR = std::none_of(std::get<0>(internal_dfa[trans]).begin(),
+                                         std::get<0>(internal_dfa[trans]).end(),
                                          [&](const addrint_value_map_t& addr_val)
           {
             return (std::get<1>(*addr_val.begin()) == 13); // a hack
@@ -1285,7 +1621,8 @@ auto execution_dfa::pre_processing () -> void
           auto to_NULL_edge_label = addrint_value_maps_t();
           auto to_not_LN_CR_NULL_label = addrint_value_maps_t();
 
-          std::for_each(internal_dfa[to_terminal_edge].begin(), internal_dfa[to_terminal_edge].end(),
+          std::for_each(std::get<0>(internal_dfa[to_terminal_edge]).begin(),
+                        std::get<0>(internal_dfa[to_terminal_edge]).end(),
                         [&](const addrint_value_map_t& addr_val)
           {
             switch (std::get<1>(*addr_val.begin()))
@@ -1302,9 +1639,9 @@ auto execution_dfa::pre_processing () -> void
             }
           });
 
-          internal_dfa[to_terminal_edge] = to_not_LN_CR_NULL_label;
-          boost::add_edge(state, LN_state, to_LN_edge_label, internal_dfa);
-          boost::add_edge(state, NULL_state, to_NULL_edge_label, internal_dfa);
+          internal_dfa[to_terminal_edge] = labeled_transition(to_not_LN_CR_NULL_label);
+          boost::add_edge(state, LN_state, labeled_transition(to_LN_edge_label), internal_dfa);
+          boost::add_edge(state, NULL_state, labeled_transition(to_NULL_edge_label), internal_dfa);
         }
       }
     }
@@ -1321,8 +1658,9 @@ auto execution_dfa::pre_processing () -> void
         if (std::any_of(first_trans_iter, last_trans_iter, [](dfa_edge_desc trans)
         {
           auto to_terminal = internal_dfa[boost::target(trans, internal_dfa)].empty();
-          auto cond_size = internal_dfa[trans].size();
-          auto lack_of_LN_NULL = std::none_of(internal_dfa[trans].begin(), internal_dfa[trans].end(),
+          auto cond_size = std::get<0>(internal_dfa[trans]).size();
+          auto lack_of_LN_NULL = std::none_of(std::get<0>(internal_dfa[trans]).begin(),
+                                              std::get<0>(internal_dfa[trans]).end(),
                                          [&](const addrint_value_map_t& addr_val)
           {
             return (std::get<1>(*addr_val.begin()) == 0) || (std::get<1>(*addr_val.begin()) == 10); // a hack
@@ -1335,7 +1673,7 @@ auto execution_dfa::pre_processing () -> void
                                                        last_trans_iter, [](dfa_edge_desc trans)
           {
             return internal_dfa[boost::target(trans, internal_dfa)].empty() &&
-                   (internal_dfa[trans].size() == 254);
+                   (std::get<0>(internal_dfa[trans]).size() == 254);
           });
 
           auto CR_state = boost::add_vertex(ptr_cond_direct_inss_t(), internal_dfa);
@@ -1345,8 +1683,8 @@ auto execution_dfa::pre_processing () -> void
 //          auto to_NULL_edge_label = addrint_value_maps_t();
           auto to_not_LN_CR_NULL_label = addrint_value_maps_t();
 
-          std::for_each(internal_dfa[to_lack_of_LN_NULL_edge].begin(),
-                        internal_dfa[to_lack_of_LN_NULL_edge].end(),
+          std::for_each(std::get<0>(internal_dfa[to_lack_of_LN_NULL_edge]).begin(),
+                        std::get<0>(internal_dfa[to_lack_of_LN_NULL_edge]).end(),
                         [&](const addrint_value_map_t& addr_val)
           {
             switch (std::get<1>(*addr_val.begin()))
@@ -1360,8 +1698,8 @@ auto execution_dfa::pre_processing () -> void
             }
           });
 
-          internal_dfa[to_lack_of_LN_NULL_edge] = to_not_LN_CR_NULL_label;
-          boost::add_edge(state, CR_state, to_CR_edge_label, internal_dfa);
+          internal_dfa[to_lack_of_LN_NULL_edge] = labeled_transition(to_not_LN_CR_NULL_label);
+          boost::add_edge(state, CR_state, labeled_transition(to_CR_edge_label), internal_dfa);
 //          boost::add_edge(state, NULL_state, to_NULL_edge_label, internal_dfa);
         }
       }
@@ -1485,33 +1823,28 @@ static auto pre_process_least_states () -> void
 }
 
 /**
- * @brief execution_dfa::co_optimize
+ * @brief execution_dfa::co_optimize: the exact minimization, it merges only equivalent states
  */
-//auto execution_dfa::co_optimize () -> void
-//{
-//  auto equiv_relation = natural_equivalence();
-//  construct_quotient_dfa_from_equivalence(equiv_relation);
+auto execution_dfa::co_optimize () -> void
+{
+  construct_quotient_dfa_from_partition(minimal_equivalence_partition());
 
-////  equiv_relation = natural_unification();
-////  construct_quotient_dfa_from_equivalence(equiv_relation);
-//  return;
-//}
+//  equiv_relation = natural_unification();
+//  construct_quotient_dfa_from_equivalence(equiv_relation);
+  return;
+}
 
 
 auto execution_dfa::co_approximate () -> void
 {
   pre_process_least_states();
 
-  auto equiv_relation = state_pairs_t();
+  auto equiv_relation = state_relation_t();
   while (true)
   {
     equiv_relation = natural_approximation();
-    if (std::all_of(std::begin(equiv_relation), std::end(equiv_relation),
-                    [](decltype(equiv_relation)::const_reference state_pair)
-    {
-      return (std::get<0>(state_pair) == std::get<1>(state_pair));
-    })) break;
-    else construct_quotient_dfa_from_equivalence(equiv_relation);
+    if (equiv_relation.is_identity()) break;
+    else construct_quotient_dfa_from_partition(equiv_relation.partition());
   }
 
 //  equiv_relation = natural_approximation();
@@ -1532,8 +1865,7 @@ auto execution_dfa::co_approximate () -> void
 //  equiv_relation = natural_approximation();
 //  construct_quotient_dfa_from_equivalence(equiv_relation);
 
-  equiv_relation = natural_unification();
-  construct_quotient_dfa_from_equivalence(equiv_relation);
+  construct_quotient_dfa_from_partition(natural_unification());
   return;
 }
 
@@ -2127,7 +2459,7 @@ auto execution_dfa::co_approximate () -> void
  */
 auto execution_dfa::save_to_file (const std::string& filename) -> void
 {
-  auto transition_label = [](const dfa_edge& trans_cond) -> std::string
+  auto transition_label = [](const addrint_value_maps_t& trans_cond) -> std::string
   {
     auto trans_values = std::vector<UINT8>(); trans_values.reserve(trans_cond.size());
     std::for_each(std::begin(trans_cond), std::end(trans_cond),
@@ -2188,7 +2520,7 @@ auto execution_dfa::save_to_file (const std::string& filename) -> void
 
   auto write_dfa_transition = [&transition_label](std::ostream& label, dfa_edge_desc trans) -> void
   {
-    auto trans_cond = internal_dfa[trans];
+    auto trans_cond = std::get<0>(internal_dfa[trans]);
     tfm::format(label, "[label=\"%s\"]", transition_label(trans_cond));
 
 //    if (trans_cond.size() <= 3)
@@ -2321,3 +2653,124 @@ auto execution_dfa::save_to_file (const std::string& filename) -> void
   dfa_file.close();
   return;
 }
+
+
+/**
+ * @brief execution_dfa::save_to_table: save the DFA as a transition table over input bytes for the
+ * standalone matcher (tools/dfa_matcher.h). A transition of n-byte maps consumes n bytes (so
+ * intermediate states are added for n > 1), a state without CFI (except the initial state) is
+ * accepting, and bytes having the same transitions from every state share one class. The table is
+ * deterministic on bytes: when labels of transitions from a state overlap, the first one is kept.
+ */
+auto execution_dfa::save_to_table (const std::string& filename) -> void
+{
+  // rows of 256 next states, the rows of the DFA states are followed by intermediate rows
+  auto byte_rows = std::vector<uint32_t>(); auto accepting = std::vector<uint8_t>();
+  auto add_row = [&](bool is_accepting) -> uint32_t
+  {
+    byte_rows.insert(std::end(byte_rows), 256, dfa_table_reject);
+    accepting.push_back(is_accepting ? 1 : 0);
+    return static_cast<uint32_t>(accepting.size() - 1);
+  };
+
+  auto row_of_state = std::map<dfa_vertex_desc, uint32_t>();
+  auto first_state = dfa_vertex_iter(); auto last_state = dfa_vertex_iter();
+  std::tie(first_state, last_state) = boost::vertices(internal_dfa);
+  std::for_each(first_state, last_state, [&](dfa_vertex_desc state)
+  {
+    row_of_state[state] = add_row(internal_dfa[state].empty() && (state != initial_state));
+  });
+
+  auto first_trans = dfa_edge_iter(); auto last_trans = dfa_edge_iter();
+  std::tie(first_trans, last_trans) = boost::edges(internal_dfa);
+  std::for_each(first_trans, last_trans, [&](dfa_edge_desc trans)
+  {
+    auto source_row = row_of_state[boost::source(trans, internal_dfa)];
+    auto target_row = row_of_state[boost::target(trans, internal_dfa)];
+    const auto& trans_label = std::get<1>(internal_dfa[trans]);
+
+    if (trans_label.is_byte_set)
+    {
+      for (auto value = 0; value < 256; ++value)
+      {
+        auto& next_row = byte_rows[source_row * 256 + value];
+        if (trans_label.byte_values.test(value) && (next_row == dfa_table_reject))
+          next_row = target_row;
+      }
+    }
+    else
+    {
+      // intermediate rows of the transition, indexed by the bytes consumed from the source
+      auto row_of_prefix = std::map<std::vector<UINT8>, uint32_t>();
+      std::for_each(std::begin(trans_label.tuple_values), std::end(trans_label.tuple_values),
+                    [&](const std::vector<UINT8>& tuple)
+      {
+        auto current_row = source_row; auto prefix = std::vector<UINT8>();
+        for (auto idx = std::size_t(0); idx < tuple.size(); ++idx)
+        {
+          auto next_idx = current_row * 256 + tuple[idx];
+          if (idx + 1 == tuple.size())
+          {
+            if (byte_rows[next_idx] == dfa_table_reject) byte_rows[next_idx] = target_row;
+            break;
+          }
+
+          prefix.push_back(tuple[idx]);
+          auto prefix_iter = row_of_prefix.find(prefix);
+          if (prefix_iter == std::end(row_of_prefix))
+          {
+            // the byte is already consumed by a former transition
+            if (byte_rows[next_idx] != dfa_table_reject) break;
+
+            auto middle_row = add_row(false); byte_rows[next_idx] = middle_row;
+            prefix_iter = row_of_prefix.insert(std::make_pair(prefix, middle_row)).first;
+          }
+          current_row = std::get<1>(*prefix_iter);
+        }
+      });
+    }
+  });
+
+  // bytes are in the same class iff their columns in the table are identical
+  auto row_num = static_cast<uint32_t>(accepting.size());
+  auto class_of_column = std::map<std::vector<uint32_t>, uint8_t>();
+  auto class_representatives = std::vector<uint32_t>();
+  uint8_t byte_class[256];
+  for (auto value = uint32_t(0); value < 256; ++value)
+  {
+    auto column = std::vector<uint32_t>(row_num);
+    for (auto row = uint32_t(0); row < row_num; ++row) column[row] = byte_rows[row * 256 + value];
+
+    auto class_iter = class_of_column.find(column);
+    if (class_iter == std::end(class_of_column))
+    {
+      class_iter = class_of_column.insert(
+            std::make_pair(column, static_cast<uint8_t>(class_representatives.size()))).first;
+      class_representatives.push_back(value);
+    }
+    byte_class[value] = std::get<1>(*class_iter);
+  }
+
+  auto header = dfa_table_header_t();
+  header.magic = dfa_table_magic; header.version = dfa_table_version;
+  header.state_num = row_num;
+  header.class_num = static_cast<uint32_t>(class_representatives.size());
+  header.initial_state = row_of_state[initial_state];
+
+  std::ofstream table_file(("dfa_" + filename).c_str(),
+                           std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+  table_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  table_file.write(reinterpret_cast<const char*>(byte_class), sizeof(byte_class));
+  table_file.write(reinterpret_cast<const char*>(accepting.data()), accepting.size());
+  for (auto row = uint32_t(0); row < row_num; ++row)
+  {
+    std::for_each(std::begin(class_representatives), std::end(class_representatives),
+                  [&](uint32_t value)
+    {
+      table_file.write(reinterpret_cast<const char*>(&byte_rows[row * 256 + value]),
+                       sizeof(uint32_t));
+    });
+  }
+  table_file.close();
+  return;
+}
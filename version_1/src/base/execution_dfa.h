@@ -17,17 +17,19 @@ public:
 
   static auto instance      ()                                    -> ptr_exec_dfa_t;
 
+  auto add_exec_path        (const ptr_exec_path_t& exec_path)    -> void;
   auto add_exec_paths       (const ptr_exec_paths_t& exec_paths)  -> void;
 
 //  auto optimize             ()                                    -> void;
 //  auto approximate          ()                                    -> void;
 
-//  auto co_optimize          ()                                    -> void;
+  auto co_optimize          ()                                    -> void;
   auto co_approximate       ()                                    -> void;
 
   auto pre_processing       ()                                    -> void;
 
   auto save_to_file         (const std::string& filename)         -> void;
+  auto save_to_table        (const std::string& filename)         -> void;
 };
 
 #endif // EXECUTION_DFA_H
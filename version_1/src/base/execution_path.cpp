@@ -3,6 +3,7 @@
 #include "../util/stuffs.h"
 #include <functional>
 #include <algorithm>
+#include <boost/unordered_set.hpp>
 
 //typedef std::function<conditions_t ()> lazy_func_cond_t;
 
@@ -20,18 +21,8 @@ static auto two_sub_conds_are_identical (const condition_t& sub_cond_a,
 
 
 /**
- * @brief map_exists_in_maps
- */
-static auto map_exists_in_maps (const addrint_value_map_t& tested_map,
-                                const addrint_value_maps_t& maps) -> bool
-{
-  auto is_identical = std::bind(two_maps_are_identical, tested_map, std::placeholders::_1);
-  return (std::find_if(maps.begin(), maps.end(), is_identical) != maps.end());
-}
-
-
-/**
- * @brief remove duplicated map inside a vector of maps
+ * @brief remove duplicated map inside a vector of maps, maps are looked up by their hashes and the
+ * order of their first occurrences is kept
  */
 static auto remove_duplicated (const addrint_value_maps_t& input_maps) -> addrint_value_maps_t
 {
@@ -39,15 +30,11 @@ static auto remove_duplicated (const addrint_value_maps_t& input_maps) -> addrin
   auto remove_from = [&input_maps]() -> addrint_value_maps_t
   {
     addrint_value_maps_t result_maps;
+    auto examined_maps = boost::unordered_set<addrint_value_map_t>();
     std::for_each(input_maps.begin(), input_maps.end(),
                   [&](addrint_value_maps_t::const_reference examined_map)
     {
-      auto is_identical = std::bind(two_maps_are_identical, examined_map,
-                                                 std::placeholders::_1);
-      if (std::find_if(result_maps.begin(), result_maps.end(), is_identical) == result_maps.end())
-      {
-        result_maps.push_back(examined_map);
-      }
+      if (examined_maps.insert(examined_map).second) result_maps.push_back(examined_map);
     });
     return result_maps;
   };
@@ -184,6 +171,7 @@ static auto stabilize (const conditions_t& raw_cond) -> conditions_t
         const addrint_value_maps_t& maps, const addrints_t& addrs) -> addrint_value_maps_t
     {
       addrint_value_maps_t projected_maps;
+      auto existing_maps = boost::unordered_set<addrint_value_map_t>();
 
       std::for_each(maps.begin(), maps.end(), [&](addrint_value_map_t addr_val_map)
       {
@@ -194,8 +182,7 @@ static auto stabilize (const conditions_t& raw_cond) -> conditions_t
           projected_map[addr] = addr_val_map[addr];
         });
 
-        if (!map_exists_in_maps(projected_map, projected_maps))
-          projected_maps.push_back(projected_map);
+        if (existing_maps.insert(projected_map).second) projected_maps.push_back(projected_map);
       });
       return projected_maps;
     };
@@ -364,10 +351,11 @@ static auto stabilize (const conditions_t& raw_cond) -> conditions_t
  * @brief reconstruct path condition as a cartesian product A x ... x B x ...
  */
 static auto calculate_from (const order_ins_map_t& current_path,
-                            const path_code_t& current_path_code) -> conditions_t
+                            path_code_id_t current_path_code) -> conditions_t
 {
   auto raw_condition = conditions_t();
   auto current_code_order = 0;
+  auto current_path_prefixes = path_code_prefixes(current_path_code);
 
 //  tfm::format(std::cerr, "----\ncurrent path length %d with code size %d: %s\n", current_path.size(),
 //              current_path_code.size(), path_code_to_string(current_path_code));
@@ -380,8 +368,11 @@ static auto calculate_from (const order_ins_map_t& current_path,
     {
       // yes, then downcast it as a CFI
 //      auto current_cfi = std::static_pointer_cast<cond_direct_instruction>(order_ins.second);
-      auto current_cfi = look_for_saved_instance(
-            std::static_pointer_cast<cond_direct_instruction>(order_ins.second), current_path_code);
+      // the path code of the saved instance is the prefix of the current path code before this CFI
+      auto current_cfi = (current_code_order < path_code_length(current_path_code)) ?
+            look_for_saved_instance(std::static_pointer_cast<cond_direct_instruction>(order_ins.second),
+                                    current_path_prefixes[current_code_order]) :
+            ptr_cond_direct_ins_t();
       if (current_cfi)
       {
         // verify if this CFI is resolved
@@ -395,7 +386,7 @@ static auto calculate_from (const order_ins_map_t& current_path,
 //          else raw_condition.push_back(
 //                std::make_pair(remove_duplicated(current_cfi->second_input_projections),
 //                                                      ptr_cond_direct_inss_t(1, current_cfi)));
-          !current_path_code[current_code_order] ?
+          !path_code_last_bit(current_path_prefixes[current_code_order + 1]) ?
                 raw_condition.push_back(
                   std::make_pair(remove_duplicated(current_cfi->first_input_projections),
                                  ptr_cond_direct_inss_t(1, current_cfi))) :
@@ -428,21 +419,31 @@ static auto calculate_from (const order_ins_map_t& current_path,
 
 
 /**
- * @brief constructor
+ * @brief constructor, the path is interned in the tree of explored paths (only its CFIs are kept
+ * unless all instructions are requested by the knob -a)
  */
-execution_path::execution_path (const order_ins_map_t& path, const path_code_t& path_code)
+execution_path::execution_path (const order_ins_map_t& path, path_code_id_t path_code)
 {
-  this->content = path;
+  this->leaf = interned_exec_path(path, path_instructions_knob.Value());
   this->code = path_code;
 }
 
 
+/**
+ * @brief the kept instructions of the path, indexed by their execution orders
+ */
+auto execution_path::instructions () const -> order_ins_map_t
+{
+  return exec_path_content(this->leaf);
+}
+
+
 /**
  * @brief calculate path condition
  */
 auto execution_path::calculate_condition () -> void
 {
-  this->condition = calculate_from(this->content, this->code);
+  this->condition = calculate_from(this->instructions(), this->code);
 //  this->condition_is_recursive = is_recursive(this->condition);
 //  this->condition_order = order(this->condition);
 
@@ -483,19 +484,6 @@ auto execution_path::calculate_condition () -> void
 //}
 
 
-/**
- * @brief calculate conditions of all explored paths
- */
-auto calculate_exec_path_conditions(ptr_exec_paths_t& exec_paths) -> void
-{
-  std::for_each(exec_paths.begin(), exec_paths.end(), [](ptr_exec_paths_t::value_type path)
-  {
-    path->calculate_condition();
-  });
-  return;
-}
-
-
 #if !defined(NDEBUG)
 /**
  * @brief show_path_condition
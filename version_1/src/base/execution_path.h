@@ -3,6 +3,7 @@
 
 #include "../parsing_helper.h"
 #include "cond_direct_instruction.h"
+#include "exec_path_tree.h"
 
 class execution_path;
 
@@ -15,19 +16,18 @@ typedef std::vector<ptr_exec_path_t>                            ptr_exec_paths_t
 class execution_path
 {
 public:
-  order_ins_map_t   content;
-  path_code_t       code;
+  exec_node_id_t    leaf;
+  path_code_id_t    code;
   conditions_t      condition;
   int               condition_order;
   bool              condition_is_recursive;
 
-  execution_path(const order_ins_map_t& current_path, const path_code_t& current_path_code);
+  execution_path(const order_ins_map_t& current_path, path_code_id_t current_path_code);
+  auto instructions() const -> order_ins_map_t;
   auto calculate_condition() -> void;
 //  auto lazy_condition(int n) -> conditions_t;
 };
 
-auto calculate_exec_path_conditions (ptr_exec_paths_t& exec_paths) -> void;
-
 //#if !defined(NDEBUG)
 //auto show_path_condition(const ptr_exec_paths_t& exec_paths) -> void;
 //auto show_path_condition(const ptr_exec_path_t& exec_path) -> void;
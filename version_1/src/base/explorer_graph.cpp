@@ -5,12 +5,15 @@
 
 #include <boost/graph/graphviz.hpp>
 #include <boost/graph/filtered_graph.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 //#include <boost/graph/copy.hpp>
 #include <algorithm>
 #include <tuple>
+#include <unordered_map>
 
 typedef ADDRINT                                               exp_vertex;
-typedef std::pair<std::vector<bool>, addrint_value_maps_t>    exp_edge;
+typedef std::pair<path_code_id_t, addrint_value_maps_t>       exp_edge;
 typedef boost::adjacency_list<boost::listS, boost::vecS,
                               boost::bidirectionalS,
                               exp_vertex, exp_edge>           exp_graph_t;
@@ -20,7 +23,7 @@ typedef boost::graph_traits<exp_graph_t>::vertex_iterator     exp_vertex_iter;
 typedef boost::graph_traits<exp_graph_t>::edge_iterator       exp_edge_iter;
 
 typedef ptr_instruction_t                                     exp_tree_vertex_t;
-typedef path_code_t                                           exp_tree_edge_t;
+typedef path_code_id_t                                        exp_tree_edge_t;
 typedef boost::adjacency_list<boost::listS, boost::vecS,
                               boost::bidirectionalS,
                               exp_tree_vertex_t,
@@ -32,6 +35,15 @@ typedef boost::graph_traits<exp_tree_t>::edge_iterator        exp_tree_edge_iter
 
 typedef std::pair<exp_tree_edge_t, exp_tree_vertex_t>         exp_tree_with_root_t;
 
+// indexes of the graphs: vertices by their instructions, and edges by their ends and path codes
+typedef std::pair<exp_vertex_desc, exp_vertex_desc>           exp_vertex_pair_t;
+typedef boost::unordered_map<ADDRINT, exp_vertex_desc>        exp_vertex_index_t;
+typedef boost::unordered_map<std::pair<exp_vertex_pair_t, path_code_id_t>,
+                             exp_edge_desc>                   exp_edge_index_t;
+typedef boost::unordered_set<exp_vertex_pair_t>               exp_simple_edge_index_t;
+typedef std::unordered_map<exp_tree_vertex_t,
+                           exp_tree_vertex_desc>              exp_tree_vertex_index_t;
+
 /*================================================================================================*/
 
 static exp_graph_t            internal_exp_graph;
@@ -42,6 +54,12 @@ static addrint_value_map_t    default_addrs_values;
 static exp_tree_t             internal_exp_tree;
 static exp_tree_t             internal_exp_cfi_tree;
 
+static exp_vertex_index_t       vertex_at_addr;
+static exp_vertex_index_t       simple_vertex_at_addr;
+static exp_edge_index_t         edge_at_ends_and_code;
+static exp_simple_edge_index_t  simple_edge_ends;
+static exp_tree_vertex_index_t  tree_vertex_at_ins;
+
 /*================================================================================================*/
 /**
  * @brief private constructor of the explorer graph
@@ -62,18 +80,21 @@ auto explorer_graph::instance() -> ptr_explorer_graph_t
   {
     single_graph_instance = std::make_shared<explorer_graph>(private_construct_key());
     internal_exp_graph.clear(); internal_exp_graph_simple.clear(); internal_exp_tree.clear();
+    vertex_at_addr.clear(); simple_vertex_at_addr.clear(); edge_at_ends_and_code.clear();
+    simple_edge_ends.clear(); tree_vertex_at_ins.clear();
   }
   return single_graph_instance;
 }
 
 
 /**
- * @brief add a vertex into the explorer graph
+ * @brief add a vertex into the explorer graph, a later vertex of the same address shadows the
+ * former in the index (as in the former linear lookup)
  */
 auto explorer_graph::add_vertex(ADDRINT ins_addr) -> void
 {
-  boost::add_vertex(ins_addr, internal_exp_graph);
-  boost::add_vertex(ins_addr, internal_exp_graph_simple);
+  vertex_at_addr[ins_addr] = boost::add_vertex(ins_addr, internal_exp_graph);
+  simple_vertex_at_addr[ins_addr] = boost::add_vertex(ins_addr, internal_exp_graph_simple);
 
   return;
 }
@@ -84,76 +105,56 @@ auto explorer_graph::add_vertex(ADDRINT ins_addr) -> void
  */
 auto explorer_graph::add_vertex(ptr_instruction_t ins) -> void
 {
-  boost::add_vertex(ins, internal_exp_tree);
+  tree_vertex_at_ins[ins] = boost::add_vertex(ins, internal_exp_tree);
   return;
 }
 
 
 /**
- * @brief add an edge into the explorer graph
+ * @brief look for the descriptor of a vertex in an index, return the null vertex if not found
+ */
+template <typename index_t>
+static auto indexed_vertex (const index_t& vertex_index, const typename index_t::key_type& vertex,
+                            typename index_t::mapped_type null_vertex) -> typename index_t::mapped_type
+{
+  auto vertex_iter = vertex_index.find(vertex);
+  return (vertex_iter != vertex_index.end()) ? vertex_iter->second : null_vertex;
+}
+
+
+/**
+ * @brief add an edge into the explorer graph, the phase is the one when the edge is found (the
+ * graph is updated later by the FSA builder)
  */
 auto explorer_graph::add_edge(ADDRINT ins_a_addr, ADDRINT ins_b_addr,
-                              const path_code_t& edge_path_code,
+                              path_code_id_t edge_path_code, UINT32 edge_phase,
                               const addrint_value_map_t& edge_addrs_values) -> void
 {
 //  tfm::format(std::cerr, "add edge <%s -> %s>\n", addrint_to_hexstring(ins_a_addr),
 //              addrint_to_hexstring(ins_b_addr));
-//  exp_vertex_desc ins_a_desc, ins_b_desc;
-//  auto ins_a_desc = exp_vertex_desc(); auto ins_b_desc = exp_vertex_desc();
-  auto ins_a_desc = boost::graph_traits<exp_graph_t>::null_vertex();
-  auto ins_b_desc = boost::graph_traits<exp_graph_t>::null_vertex();
-
-  auto vertex_iter = exp_vertex_iter(); auto last_vertex_iter = exp_vertex_iter();
-//  exp_vertex_iter vertex_iter, last_vertex_iter;
-
   // look for descriptors of instruction a and b
-  std::tie(vertex_iter, last_vertex_iter) = boost::vertices(internal_exp_graph);
-  for (; vertex_iter != last_vertex_iter; ++vertex_iter)
+  auto null_desc = boost::graph_traits<exp_graph_t>::null_vertex();
+  auto ins_a_desc = indexed_vertex(vertex_at_addr, ins_a_addr, null_desc);
+  auto ins_b_desc = indexed_vertex(vertex_at_addr, ins_b_addr, null_desc);
+
+  // verify if there exist an edge from a to b with the same path code
+  auto edge_key = std::make_pair(std::make_pair(ins_a_desc, ins_b_desc), edge_path_code);
+  auto edge_iter = edge_at_ends_and_code.find(edge_key);
+  if (edge_iter != edge_at_ends_and_code.end())
   {
-    if (internal_exp_graph[*vertex_iter] == ins_a_addr) ins_a_desc = *vertex_iter;
-    if (internal_exp_graph[*vertex_iter] == ins_b_addr) ins_b_desc = *vertex_iter;
+    // yes, then add the selected values and addresses into the list of this edge
+    if (!edge_addrs_values.empty())
+      internal_exp_graph[edge_iter->second].second.push_back(edge_addrs_values);
   }
-
-  boost::graph_traits<exp_graph_t>::out_edge_iterator out_edge_iter, last_out_edge_iter;
-  std::tie(out_edge_iter, last_out_edge_iter) = boost::out_edges(ins_a_desc, internal_exp_graph);
-
-  // iterate over out edges from a
-  for (; out_edge_iter != last_out_edge_iter; ++out_edge_iter)
-  {
-    // verify if there exist an edge to b
-    if (boost::target(*out_edge_iter, internal_exp_graph) == ins_b_desc)
-    {
-      // lambda to verify if two path codes are equal
-      auto path_codes_are_equal = [](const path_code_t& x, const path_code_t& y) -> bool
-      {
-        if (x.size() == y.size())
-        {
-          path_code_t::const_iterator x_iter, y_iter;
-          std::tie(x_iter, y_iter) = std::mismatch(x.begin(), x.end(), y.begin());
-          if ((x_iter == x.end()) && (y_iter == y.end())) return true;
-        }
-        return false;
-      };
-      // exist, then verify if the path code of this edge is also the input path code
-      if (path_codes_are_equal(edge_path_code, internal_exp_graph[*out_edge_iter].first))
-      {
-        // yes, then add the selected values and addresses into the list of this edge
-        if (!edge_addrs_values.empty())
-          internal_exp_graph[*out_edge_iter].second.push_back(edge_addrs_values);
-        break;
-      }
-    }
-  }
-
-  // there exists no such edge with the path code, then add it as a new edge
-  if (out_edge_iter == last_out_edge_iter)
+  else
   {
-    if ((current_running_phase == rollbacking_phase) && !edge_path_code.empty() &&
-        !edge_path_code.back())
+    // there exists no such edge with the path code, then add it as a new edge
+    if ((edge_phase == rollbacking_phase) && (edge_path_code != empty_path_code) &&
+        !path_code_last_bit(edge_path_code))
     {
 #if !defined(NDEBUG)
       tfm::format(std::cerr, "fatal: edge <%s->%s> %d\n", addrint_to_hexstring(ins_a_addr),
-                  addrint_to_hexstring(ins_b_addr), edge_path_code.size());
+                  addrint_to_hexstring(ins_b_addr), path_code_length(edge_path_code));
 #endif
       PIN_ExitApplication(1);
     }
@@ -161,30 +162,25 @@ auto explorer_graph::add_edge(ADDRINT ins_a_addr, ADDRINT ins_b_addr,
     {
       addrint_value_maps_t edge_input_values;
       if (!edge_input_values.empty()) edge_input_values.push_back(edge_addrs_values);
-      boost::add_edge(ins_a_desc, ins_b_desc, std::make_pair(edge_path_code, edge_input_values),
-                      internal_exp_graph);
+      edge_at_ends_and_code[edge_key] =
+          boost::add_edge(ins_a_desc, ins_b_desc, std::make_pair(edge_path_code, edge_input_values),
+                          internal_exp_graph).first;
     }
   }
 
   // add a edge with empty label into the simple graph
 
   // look for descriptors of instruction a and b
-  std::tie(vertex_iter, last_vertex_iter) = boost::vertices(internal_exp_graph_simple);
-  for (; vertex_iter != last_vertex_iter; ++vertex_iter)
+  ins_a_desc = indexed_vertex(simple_vertex_at_addr, ins_a_addr, null_desc);
+  ins_b_desc = indexed_vertex(simple_vertex_at_addr, ins_b_addr, null_desc);
+
+  // verify if the edge from a to b exists, if not then add a new edge with empty label
+  if (simple_edge_ends.insert(std::make_pair(ins_a_desc, ins_b_desc)).second)
   {
-    if (internal_exp_graph_simple[*vertex_iter] == ins_a_addr) ins_a_desc = *vertex_iter;
-    if (internal_exp_graph_simple[*vertex_iter] == ins_b_addr) ins_b_desc = *vertex_iter;
+    boost::add_edge(ins_a_desc, ins_b_desc,
+                    std::make_pair(empty_path_code, addrint_value_maps_t()),
+                    internal_exp_graph_simple);
   }
-
-  // verify if the edge from a to b exists
-//  bool edge_exists;
-  auto edge_exists = false;
-  std::tie(std::ignore, edge_exists) = boost::edge(ins_a_desc, ins_b_desc,
-                                                   internal_exp_graph_simple);
-  // no, then add a new edge with empty label
-  if (!edge_exists) boost::add_edge(ins_a_desc, ins_b_desc,
-                                    std::make_pair(std::vector<bool>(), addrint_value_maps_t()),
-                                    internal_exp_graph_simple);
   return;
 }
 
@@ -193,17 +189,11 @@ auto explorer_graph::add_edge(ADDRINT ins_a_addr, ADDRINT ins_b_addr,
  * @brief add an edge into the explorer tree
  */
 auto explorer_graph::add_edge(ptr_instruction_t ins_a, ptr_instruction_t ins_b,
-                              const path_code_t& edge_path_code) -> void
+                              path_code_id_t edge_path_code) -> void
 {
-  exp_tree_vertex_desc vertex_a_desc, vertex_b_desc;
-  exp_tree_vertex_iter first_vertex_tree_iter, last_vertex_tree_iter;
-
-  std::tie(first_vertex_tree_iter, last_vertex_tree_iter) = boost::vertices(internal_exp_tree);
-  std::for_each(first_vertex_tree_iter, last_vertex_tree_iter, [&](exp_tree_vertex_desc vertex_desc)
-  {
-    if (internal_exp_tree[vertex_desc] == ins_a) vertex_a_desc = vertex_desc;
-    if (internal_exp_tree[vertex_desc] == ins_b) vertex_b_desc = vertex_desc;
-  });
+  auto null_desc = boost::graph_traits<exp_tree_t>::null_vertex();
+  auto vertex_a_desc = indexed_vertex(tree_vertex_at_ins, ins_a, null_desc);
+  auto vertex_b_desc = indexed_vertex(tree_vertex_at_ins, ins_b, null_desc);
   boost::add_edge(vertex_a_desc, vertex_b_desc, edge_path_code, internal_exp_tree);
 
   return;
@@ -256,7 +246,7 @@ auto explorer_graph::extract_cfi_tree () -> void
   };
 
   auto next_cfi_following_path =
-      [&](exp_tree_vertex_desc current_cfi_desc, const path_code_t& path) -> exp_tree_vertex_desc
+      [&](exp_tree_vertex_desc current_cfi_desc, path_code_id_t path) -> exp_tree_vertex_desc
   {
     auto result = boost::graph_traits<exp_tree_t>::null_vertex();
     if (current_cfi_desc != boost::graph_traits<exp_tree_t>::null_vertex())
@@ -430,12 +420,12 @@ public:
 
     auto target_vertex_desc = boost::target(edge_desc, internal_graph);
     if (is_input_dep_cfi(internal_graph[target_vertex_desc]) &&
-        !std::static_pointer_cast<cond_direct_instruction>(
-          internal_graph[target_vertex_desc])->path_code.empty())
+        (std::static_pointer_cast<cond_direct_instruction>(
+          internal_graph[target_vertex_desc])->path_code != empty_path_code))
     {
       tfm::format(label, "[label=\"%d\"]",
-                  std::static_pointer_cast<cond_direct_instruction>(
-                    internal_graph[target_vertex_desc])->path_code.back());
+                  path_code_last_bit(std::static_pointer_cast<cond_direct_instruction>(
+                                       internal_graph[target_vertex_desc])->path_code));
     }
     else
       tfm::format(label, "[label=\"\"]");
@@ -5,7 +5,6 @@
 
 class explorer_graph;
 typedef std::shared_ptr<explorer_graph>   ptr_explorer_graph_t;
-typedef std::vector<bool>                 path_code_t;
 
 class explorer_graph
 {
@@ -22,13 +21,14 @@ public:
 
   auto add_edge         (ADDRINT ins_a_addr,
                          ADDRINT ins_b_addr,
-                         const path_code_t& edge_path_code,
+                         path_code_id_t edge_path_code,
+                         UINT32 edge_phase,
                          const addrint_value_map_t&
                          edge_addrs_values = addrint_value_map_t()) -> void;
 
   auto add_edge         (ptr_instruction_t ins_a,
                          ptr_instruction_t ins_b,
-                         const path_code_t& edge_path_code)         -> void;
+                         path_code_id_t edge_path_code)             -> void;
 
   auto extract_cfi_tree ()                                          -> void;
   auto save_to_file     (std::string filename)                      -> void;
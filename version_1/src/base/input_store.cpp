@@ -0,0 +1,129 @@
+#include "input_store.h"
+
+#include <algorithm>
+
+/*================================================================================================*/
+
+// interned inputs are indexed by the hash of their content, the store does not own them so an
+// input is released once no CFI holds it anymore
+static std::multimap<UINT64, std::weak_ptr<const input_snapshot>> input_at_hash;
+
+// new inputs are patched against the latest base, an input is stored as a patch if at most
+// 1/max_patch_ratio of its bytes differ from the base
+static ptr_input_t  latest_base;
+static const UINT32 max_patch_ratio = 8;
+
+/*================================================================================================*/
+
+auto input_snapshot::byte_at (UINT32 offset) const -> UINT8
+{
+  if (this->base_bytes) return this->base_bytes.get()[offset];
+
+  auto patch_iter = this->patched_bytes.find(offset);
+  return (patch_iter != this->patched_bytes.end()) ? std::get<1>(*patch_iter)
+                                                   : this->base->byte_at(offset);
+}
+
+
+auto input_snapshot::copy_to (UINT8* buffer) const -> void
+{
+  if (this->base_bytes)
+  {
+    std::copy(this->base_bytes.get(), this->base_bytes.get() + this->size, buffer);
+  }
+  else
+  {
+    this->base->copy_to(buffer);
+    std::for_each(this->patched_bytes.begin(), this->patched_bytes.end(),
+                  [&](decltype(this->patched_bytes)::const_reference offset_value)
+    {
+      buffer[std::get<0>(offset_value)] = std::get<1>(offset_value);
+    });
+  }
+  return;
+}
+
+
+/**
+ * @brief FNV-1a hash of the content of a buffer
+ */
+static auto hash_of_buffer (const UINT8* buffer, UINT32 buffer_size) -> UINT64
+{
+  auto buffer_hash = UINT64(0xcbf29ce484222325);
+  for (UINT32 offset = 0; offset < buffer_size; ++offset)
+  {
+    buffer_hash = (buffer_hash ^ buffer[offset]) * UINT64(0x100000001b3);
+  }
+  return buffer_hash;
+}
+
+
+static auto input_has_content (const input_snapshot& input,
+                               const UINT8* buffer, UINT32 buffer_size) -> bool
+{
+  if (input.size != buffer_size) return false;
+  if (input.base_bytes) return std::equal(buffer, buffer + buffer_size, input.base_bytes.get());
+
+  for (UINT32 offset = 0; offset < buffer_size; ++offset)
+  {
+    if (input.byte_at(offset) != buffer[offset]) return false;
+  }
+  return true;
+}
+
+
+/**
+ * @brief get the interned input having the content of a buffer, a new input is interned if there
+ * is not any one
+ */
+auto intern_input (const UINT8* buffer, UINT32 buffer_size) -> ptr_input_t
+{
+  auto input_hash = hash_of_buffer(buffer, buffer_size);
+
+  // look for an interned input of the same content, released inputs are removed on the way
+  auto hash_range = input_at_hash.equal_range(input_hash);
+  for (auto input_iter = hash_range.first; input_iter != hash_range.second; )
+  {
+    auto interned_input = std::get<1>(*input_iter).lock();
+    if (!interned_input) input_iter = input_at_hash.erase(input_iter);
+    else
+    {
+      if (input_has_content(*interned_input, buffer, buffer_size)) return interned_input;
+      ++input_iter;
+    }
+  }
+
+  auto new_input = std::make_shared<input_snapshot>();
+  new_input->size = buffer_size; new_input->hash = input_hash;
+
+  // verify if the buffer differs from the latest base in a few bytes
+  if (latest_base && (latest_base->size == buffer_size))
+  {
+    for (UINT32 offset = 0; offset < buffer_size; ++offset)
+    {
+      if (buffer[offset] != latest_base->base_bytes.get()[offset])
+      {
+        new_input->patched_bytes[offset] = buffer[offset];
+        if (new_input->patched_bytes.size() > buffer_size / max_patch_ratio) break;
+      }
+    }
+  }
+
+  if (latest_base && (latest_base->size == buffer_size) &&
+      (new_input->patched_bytes.size() <= buffer_size / max_patch_ratio))
+  {
+    // yes, then the new input is a patch against the base
+    new_input->base = latest_base;
+  }
+  else
+  {
+    // no, then the new input holds all bytes and becomes the latest base
+    new_input->patched_bytes.clear();
+    new_input->base_bytes.reset(new UINT8[buffer_size], std::default_delete<UINT8[]>());
+    std::copy(buffer, buffer + buffer_size, new_input->base_bytes.get());
+    latest_base = new_input;
+  }
+
+  input_at_hash.insert(std::make_pair(input_hash, std::weak_ptr<const input_snapshot>(new_input)));
+  return new_input;
+}
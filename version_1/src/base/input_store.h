@@ -0,0 +1,33 @@
+#ifndef INPUT_STORE_H
+#define INPUT_STORE_H
+
+#include "../parsing_helper.h"
+#include <pin.H>
+
+#include <memory>
+#include <map>
+
+class input_snapshot;
+typedef std::shared_ptr<const input_snapshot> ptr_input_t;
+
+/**
+ * @brief an interned input: either a base (holding all bytes) or a sparse patch of bytes against a
+ * base; snapshots are immutable so that they are shared by all CFIs having the same input
+ */
+class input_snapshot
+{
+public:
+  UINT32                    size;
+  UINT64                    hash;
+  std::shared_ptr<UINT8>    base_bytes;
+  ptr_input_t               base;
+  std::map<UINT32, UINT8>   patched_bytes;
+
+public:
+  auto byte_at  (UINT32 offset) const   -> UINT8;
+  auto copy_to  (UINT8* buffer) const   -> void;
+};
+
+extern auto intern_input  (const UINT8* buffer, UINT32 buffer_size) -> ptr_input_t;
+
+#endif // INPUT_STORE_H
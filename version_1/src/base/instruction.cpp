@@ -3,6 +3,16 @@
 
 /*================================================================================================*/
 
+instruction::instruction() : address(0),
+  is_syscall(false), is_mem_read(false), is_mem_write(false), is_mapped_from_kernel(false),
+  is_cond_direct_cf(false), is_uncond_indirect_cf(false), has_mem_read2(false), has_real_rep(false)
+{
+#if defined(_WIN32) || defined(_WIN64)
+  this->is_in_msg_receiving = false;
+#endif
+}
+
+
 instruction::instruction(const INS& ins)
 {
   // collect some informations
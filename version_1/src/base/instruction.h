@@ -46,5 +46,6 @@ public:
 typedef std::shared_ptr<instruction>          ptr_instruction_t;
 typedef std::map<ADDRINT, ptr_instruction_t>  addr_ins_map_t;
 typedef std::map<UINT32, ptr_instruction_t>   order_ins_map_t;
+typedef ADDRINT                               path_hash_t;
 
 #endif // INSTRUCTION_H
@@ -0,0 +1,288 @@
+#include "instruction_cache.h"
+#include "../common.h"
+
+#include <fstream>
+#include <map>
+#include <algorithm>
+
+/*================================================================================================*/
+
+// static descriptors of instructions are cached per image; the cache file of an image is named by
+// the hash of the image file and by its load bias, so a modified or relocated image never reuses
+// stale descriptors
+typedef struct
+{
+  std::string     file_name;
+  addr_ins_map_t  ins_at_addr;
+  bool            is_modified;
+}                                           image_cache_t;
+
+static std::string                          cache_directory;
+static std::map<ADDRINT, image_cache_t>     image_cache_at_low_addr;
+
+static const UINT32 cache_magic_number    = 0x43495850; // "PXIC"
+static const UINT32 cache_format_version  = 1;
+
+/*================================================================================================*/
+
+template <typename T>
+static auto write_value (std::ofstream& cache_file, const T& value) -> void
+{
+  cache_file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  return;
+}
+
+
+template <typename T>
+static auto read_value (std::ifstream& cache_file, T& value) -> bool
+{
+  return static_cast<bool>(cache_file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+
+static auto write_string (std::ofstream& cache_file, const std::string& value) -> void
+{
+  write_value(cache_file, static_cast<UINT32>(value.size()));
+  cache_file.write(value.data(), value.size());
+  return;
+}
+
+
+static auto read_string (std::ifstream& cache_file, std::string& value) -> bool
+{
+  UINT32 value_size;
+  if (!read_value(cache_file, value_size)) return false;
+
+  value.resize(value_size);
+  return (value_size == 0) || static_cast<bool>(cache_file.read(&value[0], value_size));
+}
+
+
+static auto write_registers (std::ofstream& cache_file, const ptr_operand_set_t& operands) -> void
+{
+  write_value(cache_file, static_cast<UINT32>(operands.size()));
+  std::for_each(operands.begin(), operands.end(), [&](ptr_operand_set_t::const_reference opr)
+  {
+    write_value(cache_file, static_cast<UINT32>(boost::get<REG>(opr->exact_value)));
+  });
+  return;
+}
+
+
+static auto read_registers (std::ifstream& cache_file, ptr_operand_set_t& operands) -> bool
+{
+  UINT32 reg_num, reg;
+  if (!read_value(cache_file, reg_num)) return false;
+
+  for (UINT32 reg_idx = 0; reg_idx < reg_num; ++reg_idx)
+  {
+    if (!read_value(cache_file, reg)) return false;
+    operands.insert(std::make_shared<operand>(static_cast<REG>(reg)));
+  }
+  return true;
+}
+
+
+/**
+ * @brief flags of an instruction packed in a single word
+ */
+static auto instruction_flags (const instruction& ins) -> UINT32
+{
+  auto flags = UINT32(0);
+  if (ins.is_syscall)             flags |= 1 << 0;
+  if (ins.is_mem_read)            flags |= 1 << 1;
+  if (ins.is_mem_write)           flags |= 1 << 2;
+  if (ins.is_mapped_from_kernel)  flags |= 1 << 3;
+  if (ins.is_cond_direct_cf)      flags |= 1 << 4;
+  if (ins.is_uncond_indirect_cf)  flags |= 1 << 5;
+  if (ins.has_mem_read2)          flags |= 1 << 6;
+  if (ins.has_real_rep)           flags |= 1 << 7;
+#if defined(_WIN32) || defined(_WIN64)
+  if (ins.is_in_msg_receiving)    flags |= 1 << 8;
+#endif
+  return flags;
+}
+
+
+static auto set_instruction_flags (instruction& ins, UINT32 flags) -> void
+{
+  ins.is_syscall            = ((flags & (1 << 0)) != 0);
+  ins.is_mem_read           = ((flags & (1 << 1)) != 0);
+  ins.is_mem_write          = ((flags & (1 << 2)) != 0);
+  ins.is_mapped_from_kernel = ((flags & (1 << 3)) != 0);
+  ins.is_cond_direct_cf     = ((flags & (1 << 4)) != 0);
+  ins.is_uncond_indirect_cf = ((flags & (1 << 5)) != 0);
+  ins.has_mem_read2         = ((flags & (1 << 6)) != 0);
+  ins.has_real_rep          = ((flags & (1 << 7)) != 0);
+#if defined(_WIN32) || defined(_WIN64)
+  ins.is_in_msg_receiving   = ((flags & (1 << 8)) != 0);
+#endif
+  return;
+}
+
+
+/**
+ * @brief FNV-1a hash of the content of a file, 0 if the file cannot be read
+ */
+static auto hash_of_file (const std::string& file_name) -> UINT64
+{
+  std::ifstream img_file(file_name.c_str(), std::ifstream::in | std::ifstream::binary);
+  if (!img_file) return 0;
+
+  auto file_hash = UINT64(0xcbf29ce484222325);
+  char buffer[1 << 16];
+  while (img_file.read(buffer, sizeof(buffer)) || (img_file.gcount() > 0))
+  {
+    for (auto idx = std::streamsize(0); idx < img_file.gcount(); ++idx)
+    {
+      file_hash = (file_hash ^ static_cast<UINT8>(buffer[idx])) * UINT64(0x100000001b3);
+    }
+  }
+  return file_hash;
+}
+
+
+/**
+ * @brief load the descriptors of a cache file, a malformed file is simply ignored (the
+ * descriptors will be recomputed and the file rewritten)
+ */
+static auto load_image_cache (image_cache_t& img_cache, const std::string& img_name) -> void
+{
+  std::ifstream cache_file(img_cache.file_name.c_str(), std::ifstream::in | std::ifstream::binary);
+  if (!cache_file) return;
+
+  UINT32 magic_number, format_version, ins_num, flags;
+  if (!read_value(cache_file, magic_number) || (magic_number != cache_magic_number) ||
+      !read_value(cache_file, format_version) || (format_version != cache_format_version) ||
+      !read_value(cache_file, ins_num)) return;
+
+  addr_ins_map_t loaded_ins_at_addr;
+  for (UINT32 ins_idx = 0; ins_idx < ins_num; ++ins_idx)
+  {
+    auto loaded_ins = std::make_shared<instruction>();
+    if (!read_value(cache_file, loaded_ins->address) || !read_value(cache_file, flags) ||
+        !read_string(cache_file, loaded_ins->disassembled_name) ||
+        !read_string(cache_file, loaded_ins->contained_function) ||
+        !read_registers(cache_file, loaded_ins->src_operands) ||
+        !read_registers(cache_file, loaded_ins->dst_operands)) return;
+
+    set_instruction_flags(*loaded_ins, flags);
+    loaded_ins->contained_image = img_name;
+    loaded_ins_at_addr[loaded_ins->address] = loaded_ins;
+  }
+
+  img_cache.ins_at_addr.swap(loaded_ins_at_addr);
+  return;
+}
+
+
+/**
+ * @brief get the cache of the image containing an address, the cache is loaded at the first
+ * access; return 0 if the address is not in any image or the cache is disabled
+ */
+static auto image_cache (ADDRINT ins_addr) -> image_cache_t*
+{
+  if (cache_directory.empty()) return 0;
+
+  auto ins_img = IMG_FindByAddress(ins_addr);
+  if (!IMG_Valid(ins_img)) return 0;
+
+  auto img_low_addr = IMG_LowAddress(ins_img);
+  auto img_cache_iter = image_cache_at_low_addr.find(img_low_addr);
+  if (img_cache_iter == image_cache_at_low_addr.end())
+  {
+    auto img_name = IMG_Name(ins_img);
+    auto img_base_name = img_name.substr(img_name.find_last_of("/\\") + 1);
+
+    image_cache_t img_cache;
+    img_cache.file_name = tfm::format("%s/%s_%016x_%x.cache", cache_directory, img_base_name,
+                                      hash_of_file(img_name), IMG_LoadOffset(ins_img));
+    img_cache.is_modified = false;
+    load_image_cache(img_cache, img_name);
+
+#if !defined(NDEBUG)
+    tfm::format(log_file, "%d cached instructions loaded for %s\n", img_cache.ins_at_addr.size(),
+                img_name);
+#endif
+
+    img_cache_iter = image_cache_at_low_addr.insert(std::make_pair(img_low_addr, img_cache)).first;
+  }
+
+  return &img_cache_iter->second;
+}
+
+
+/**
+ * @brief initialize_instruction_cache, an empty directory disables the cache
+ */
+auto initialize_instruction_cache (const std::string& cache_dir) -> void
+{
+  cache_directory = cache_dir; image_cache_at_low_addr.clear();
+  return;
+}
+
+
+/**
+ * @brief get the cached descriptor of the instruction at an address, 0 if it is not cached
+ */
+auto cached_instruction (ADDRINT ins_addr) -> ptr_instruction_t
+{
+  auto img_cache = image_cache(ins_addr);
+  if (img_cache)
+  {
+    auto ins_iter = img_cache->ins_at_addr.find(ins_addr);
+    if (ins_iter != img_cache->ins_at_addr.end()) return ins_iter->second;
+  }
+  return ptr_instruction_t();
+}
+
+
+/**
+ * @brief store the descriptor of a newly examined instruction into the cache of its image
+ */
+auto cache_instruction (ptr_instruction_t examined_ins) -> void
+{
+  auto img_cache = image_cache(examined_ins->address);
+  if (img_cache)
+  {
+    img_cache->ins_at_addr[examined_ins->address] = examined_ins; img_cache->is_modified = true;
+  }
+  return;
+}
+
+
+/**
+ * @brief rewrite the cache files of images having new descriptors
+ */
+auto save_instruction_cache () -> void
+{
+  std::for_each(image_cache_at_low_addr.begin(), image_cache_at_low_addr.end(),
+                [&](decltype(image_cache_at_low_addr)::const_reference img_cache_elem)
+  {
+    auto& img_cache = std::get<1>(img_cache_elem);
+    if (img_cache.is_modified)
+    {
+      std::ofstream cache_file(img_cache.file_name.c_str(),
+                               std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+      if (cache_file)
+      {
+        write_value(cache_file, cache_magic_number);
+        write_value(cache_file, cache_format_version);
+        write_value(cache_file, static_cast<UINT32>(img_cache.ins_at_addr.size()));
+
+        std::for_each(img_cache.ins_at_addr.begin(), img_cache.ins_at_addr.end(),
+                      [&](addr_ins_map_t::const_reference addr_ins)
+        {
+          auto& cached_ins = *std::get<1>(addr_ins);
+          write_value(cache_file, cached_ins.address);
+          write_value(cache_file, instruction_flags(cached_ins));
+          write_string(cache_file, cached_ins.disassembled_name);
+          write_string(cache_file, cached_ins.contained_function);
+          write_registers(cache_file, cached_ins.src_operands);
+          write_registers(cache_file, cached_ins.dst_operands);
+        });
+      }
+    }
+  });
+  return;
+}
@@ -0,0 +1,17 @@
+#ifndef INSTRUCTION_CACHE_H
+#define INSTRUCTION_CACHE_H
+
+#include "../parsing_helper.h"
+#include "instruction.h"
+
+#include <string>
+
+extern auto initialize_instruction_cache  (const std::string& cache_dir)  -> void;
+
+extern auto cached_instruction            (ADDRINT ins_addr)              -> ptr_instruction_t;
+
+extern auto cache_instruction             (ptr_instruction_t examined_ins) -> void;
+
+extern auto save_instruction_cache        ()                              -> void;
+
+#endif // INSTRUCTION_CACHE_H
@@ -0,0 +1,98 @@
+#include "path_code_trie.h"
+
+#include <algorithm>
+
+/*================================================================================================*/
+
+// a node of the trie, children are interned lazily (0 means no child since the root is never a
+// child), so memory grows with the number of distinct codes rather than with their total length
+struct path_code_node_t
+{
+  path_code_id_t  parent;
+  path_code_id_t  child[2];
+  UINT32          length;
+  bool            last_bit;
+};
+
+static std::vector<path_code_node_t> path_code_nodes(1, path_code_node_t{ empty_path_code,
+                                                                          { 0, 0 }, 0, false });
+
+/*================================================================================================*/
+
+/**
+ * @brief the ancestor of the given length of a code (i.e. its prefix of this length)
+ */
+static auto ancestor_of_length (path_code_id_t code, UINT32 length) -> path_code_id_t
+{
+  while (path_code_nodes[code].length > length) code = path_code_nodes[code].parent;
+  return code;
+}
+
+
+/**
+ * @brief the code extended by one bit, it is interned if it does not exist yet
+ */
+auto extended_path_code (path_code_id_t prefix, bool last_bit) -> path_code_id_t
+{
+  auto child = path_code_nodes[prefix].child[last_bit];
+  if (child == 0)
+  {
+    child = static_cast<path_code_id_t>(path_code_nodes.size());
+    path_code_nodes.push_back(path_code_node_t{ prefix, { 0, 0 },
+                                                path_code_nodes[prefix].length + 1, last_bit });
+    path_code_nodes[prefix].child[last_bit] = child;
+  }
+  return child;
+}
+
+
+auto path_code_length (path_code_id_t code) -> UINT32
+{
+  return path_code_nodes[code].length;
+}
+
+
+auto path_code_last_bit (path_code_id_t code) -> bool
+{
+  return path_code_nodes[code].last_bit;
+}
+
+
+/**
+ * @brief verify if a code is a prefix of another, i.e. it is an ancestor in the trie
+ */
+auto path_code_is_prefix (path_code_id_t prefix, path_code_id_t code) -> bool
+{
+  return (path_code_nodes[prefix].length <= path_code_nodes[code].length) &&
+      (ancestor_of_length(code, path_code_nodes[prefix].length) == prefix);
+}
+
+
+/**
+ * @brief the bits of a code, from the first one
+ */
+auto path_code_bits (path_code_id_t code) -> path_code_t
+{
+  path_code_t bits;
+  for (; code != empty_path_code; code = path_code_nodes[code].parent)
+  {
+    bits.push_back(path_code_nodes[code].last_bit);
+  }
+  std::reverse(bits.begin(), bits.end());
+  return bits;
+}
+
+
+/**
+ * @brief the prefixes of a code ordered by their length, from the empty code to the code itself
+ */
+auto path_code_prefixes (path_code_id_t code) -> std::vector<path_code_id_t>
+{
+  std::vector<path_code_id_t> prefixes(1, code);
+  for (; code != empty_path_code; code = path_code_nodes[code].parent)
+  {
+    prefixes.push_back(path_code_nodes[code].parent);
+  }
+  std::reverse(prefixes.begin(), prefixes.end());
+  return prefixes;
+}
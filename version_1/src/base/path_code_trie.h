@@ -0,0 +1,28 @@
+#ifndef PATH_CODE_TRIE_H
+#define PATH_CODE_TRIE_H
+
+#include "../parsing_helper.h"
+#include <pin.H>
+
+#include <vector>
+
+// a path code is interned as a node of a trie: the parent of a code is its prefix without the last
+// bit, the root (id 0) is the empty code
+typedef std::vector<bool>                           path_code_t;
+typedef UINT32                                      path_code_id_t;
+
+static const path_code_id_t                         empty_path_code = 0;
+
+extern auto extended_path_code  (path_code_id_t prefix, bool last_bit)        -> path_code_id_t;
+
+extern auto path_code_length    (path_code_id_t code)                         -> UINT32;
+
+extern auto path_code_last_bit  (path_code_id_t code)                         -> bool;
+
+extern auto path_code_is_prefix (path_code_id_t prefix, path_code_id_t code)  -> bool;
+
+extern auto path_code_bits      (path_code_id_t code)                         -> path_code_t;
+
+extern auto path_code_prefixes  (path_code_id_t code)                 -> std::vector<path_code_id_t>;
+
+#endif // PATH_CODE_TRIE_H
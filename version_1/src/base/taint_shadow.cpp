@@ -0,0 +1,107 @@
+#include "taint_shadow.h"
+
+#include <algorithm>
+#include <iterator>
+#include <boost/unordered_map.hpp>
+
+/*================================================================================================*/
+
+// the shadow memory has two levels: a page table indexed by the page number of addresses, and pages
+// of labels indexed by the offset of addresses; a page is allocated only when some byte of it is
+// tainted. An untainted byte (or register) has an empty label pointer.
+static const UINT32 shadow_page_bits = 12;
+static const UINT32 shadow_page_size = 1 << shadow_page_bits;
+
+typedef std::shared_ptr<ptr_taint_label_t>                shadow_page_t;
+typedef boost::unordered_map<ADDRINT, shadow_page_t>      shadow_page_table_t;
+
+static shadow_page_table_t  shadow_page_at_number;
+static ptr_taint_label_t    shadow_reg_label[REG_LAST];
+
+/*================================================================================================*/
+
+/**
+ * @brief clear_taint_shadow
+ */
+auto clear_taint_shadow () -> void
+{
+  shadow_page_at_number.clear();
+  std::fill(std::begin(shadow_reg_label), std::end(shadow_reg_label), ptr_taint_label_t());
+  return;
+}
+
+
+/**
+ * @brief mem_taint_label
+ */
+auto mem_taint_label (ADDRINT mem_addr) -> ptr_taint_label_t
+{
+  auto page_iter = shadow_page_at_number.find(mem_addr >> shadow_page_bits);
+  if (page_iter == shadow_page_at_number.end()) return ptr_taint_label_t();
+  return page_iter->second.get()[mem_addr & (shadow_page_size - 1)];
+}
+
+
+/**
+ * @brief set_mem_taint_label
+ */
+auto set_mem_taint_label (ADDRINT mem_addr, ptr_taint_label_t label) -> void
+{
+  auto page_number = mem_addr >> shadow_page_bits;
+  auto page_iter = shadow_page_at_number.find(page_number);
+  if (page_iter == shadow_page_at_number.end())
+  {
+    // untainting a byte of an unallocated page changes nothing
+    if (!label) return;
+    page_iter = shadow_page_at_number.insert(std::make_pair(
+        page_number, shadow_page_t(new ptr_taint_label_t[shadow_page_size],
+                                   std::default_delete<ptr_taint_label_t[]>()))).first;
+  }
+  page_iter->second.get()[mem_addr & (shadow_page_size - 1)] = label;
+  return;
+}
+
+
+/**
+ * @brief reg_taint_label, sub-registers share the label of their full register
+ */
+auto reg_taint_label (REG reg) -> ptr_taint_label_t
+{
+  return shadow_reg_label[REG_FullRegName(reg)];
+}
+
+
+/**
+ * @brief set_reg_taint_label, the label replaces the one of the full register only if the write
+ * defines the whole register (the full register itself, or a 32-bit sub-register of a 64-bit one
+ * since its upper half is zeroed); a write into a smaller sub-register (e.g. al or ax) keeps the
+ * other bytes, so the label is merged with the one of the full register
+ */
+auto set_reg_taint_label (REG reg, ptr_taint_label_t label) -> void
+{
+  auto full_reg = REG_FullRegName(reg);
+  auto write_is_full = (reg == full_reg) || ((REG_Size(reg) == 4) && (REG_Size(full_reg) == 8));
+  shadow_reg_label[full_reg] = write_is_full ? label
+                                             : merged_taint_label(shadow_reg_label[full_reg], label);
+  return;
+}
+
+
+/**
+ * @brief merged_taint_label, a new label is created only if none of the labels contains the other
+ */
+auto merged_taint_label (ptr_taint_label_t first_label,
+                         ptr_taint_label_t second_label) -> ptr_taint_label_t
+{
+  if (!first_label || (first_label == second_label)) return second_label;
+  if (!second_label) return first_label;
+
+  if (std::includes(first_label->begin(), first_label->end(),
+                    second_label->begin(), second_label->end())) return first_label;
+  if (std::includes(second_label->begin(), second_label->end(),
+                    first_label->begin(), first_label->end())) return second_label;
+
+  auto new_label = std::make_shared<std::set<ADDRINT>>(*first_label);
+  new_label->insert(second_label->begin(), second_label->end());
+  return new_label;
+}
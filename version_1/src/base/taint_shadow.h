@@ -0,0 +1,29 @@
+#ifndef TAINT_SHADOW_H
+#define TAINT_SHADOW_H
+
+#include "../parsing_helper.h"
+#include <pin.H>
+
+#include <memory>
+#include <set>
+
+/**
+ * @brief a taint label is the set of input addresses on which a byte (or a register) depends, labels
+ * are immutable so that they are shared between shadow bytes and registers
+ */
+typedef std::shared_ptr<const std::set<ADDRINT>>  ptr_taint_label_t;
+
+extern auto clear_taint_shadow    ()                                            -> void;
+
+extern auto mem_taint_label       (ADDRINT mem_addr)                            -> ptr_taint_label_t;
+
+extern auto set_mem_taint_label   (ADDRINT mem_addr, ptr_taint_label_t label)   -> void;
+
+extern auto reg_taint_label       (REG reg)                                     -> ptr_taint_label_t;
+
+extern auto set_reg_taint_label   (REG reg, ptr_taint_label_t label)            -> void;
+
+extern auto merged_taint_label    (ptr_taint_label_t first_label,
+                                   ptr_taint_label_t second_label)              -> ptr_taint_label_t;
+
+#endif // TAINT_SHADOW_H
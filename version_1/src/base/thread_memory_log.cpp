@@ -0,0 +1,179 @@
+#include "thread_memory_log.h"
+
+#include <atomic>
+#include <algorithm>
+
+/*================================================================================================*/
+
+// the log of a thread: its write records, the size of the records after the last pruning, and the
+// top of its stack (writes into its own stack are not logged)
+typedef struct
+{
+  mem_write_records_t records;
+  std::size_t         pruned_size;
+  ADDRINT             stack_top;
+}                                 thread_mem_log_t;
+
+// the sequencer orders memory writes of all threads without any lock: each write takes a unique
+// sequence number, each thread appends its records into its own log (as a thread local data);
+// records older than the pruning sequence (the one of the earliest live checkpoint) are never
+// restored, each thread drops them from its own log
+static std::atomic<UINT64>  write_sequencer(0);
+static std::atomic<UINT64>  pruning_sequence(0);
+static TLS_KEY              thread_log_key;
+
+// the area below the stack pointer which may be written without moving the pointer
+static const ADDRINT        stack_red_zone = 128;
+// a log is pruned whenever its size doubles since its last pruning, but not below this size
+static const std::size_t    min_pruned_size = 4096;
+
+/*================================================================================================*/
+
+static auto thread_log (THREADID thread_id) -> thread_mem_log_t*
+{
+  return static_cast<thread_mem_log_t*>(PIN_GetThreadData(thread_log_key, thread_id));
+}
+
+
+static auto thread_starting (THREADID thread_id, CONTEXT* p_ctxt, INT32 flags, VOID* data) -> VOID
+{
+  PIN_SetThreadData(thread_log_key,
+                    new thread_mem_log_t{ mem_write_records_t(), 0,
+                                          PIN_GetContextReg(p_ctxt, REG_STACK_PTR) }, thread_id);
+  return;
+}
+
+
+static auto thread_finishing (THREADID thread_id, const CONTEXT* p_ctxt, INT32 code,
+                              VOID* data) -> VOID
+{
+  delete thread_log(thread_id); PIN_SetThreadData(thread_log_key, 0, thread_id);
+  return;
+}
+
+
+/**
+ * @brief drop the records older than the pruning sequence, the records of a log are ordered by
+ * their sequence numbers
+ */
+static auto prune_thread_log (thread_mem_log_t* log) -> void
+{
+  auto first_kept_record = std::lower_bound(log->records.begin(), log->records.end(),
+                                            pruning_sequence.load(),
+                                            [](mem_write_records_t::const_reference record,
+                                               UINT64 sequence) -> bool
+  {
+    return (record.sequence < sequence);
+  });
+  log->records.erase(log->records.begin(), first_kept_record);
+  log->pruned_size = log->records.size();
+  return;
+}
+
+
+/**
+ * @brief initialize_thread_memory_logs, must be called before the program starts
+ */
+auto initialize_thread_memory_logs () -> void
+{
+  thread_log_key = PIN_CreateThreadDataKey(0);
+  PIN_AddThreadStartFunction(thread_starting, 0);
+  PIN_AddThreadFiniFunction(thread_finishing, 0);
+  return;
+}
+
+
+/**
+ * @brief the sequence number of the next memory write, a checkpoint is stamped by this number
+ */
+auto current_write_sequence () -> UINT64
+{
+  return write_sequencer.load();
+}
+
+
+/**
+ * @brief log the original values of addresses written by a thread which is not the traced one;
+ * writes into the own stack of the thread are not logged: the thread keeps running with its
+ * current registers after a rollback, so restoring its frames would corrupt it
+ */
+auto thread_mem_write_tracking (THREADID thread_id, ADDRINT mem_addr, UINT32 mem_length,
+                                ADDRINT stack_ptr) -> void
+{
+  auto log = thread_log(thread_id);
+  if (log)
+  {
+    log->stack_top = std::max(log->stack_top, stack_ptr);
+    if ((mem_addr + mem_length > stack_ptr - stack_red_zone) && (mem_addr <= log->stack_top))
+      return;
+
+    auto sequence = write_sequencer.fetch_add(1);
+    UINT8 single_byte;
+    for (UINT32 mem_idx = 0; mem_idx < mem_length; ++mem_idx)
+    {
+      PIN_SafeCopy(&single_byte, reinterpret_cast<UINT8*>(mem_addr + mem_idx), sizeof(UINT8));
+      log->records.push_back({ sequence, mem_addr + mem_idx, single_byte });
+    }
+
+    if (log->records.size() >= 2 * std::max(log->pruned_size, min_pruned_size))
+      prune_thread_log(log);
+  }
+  return;
+}
+
+
+/**
+ * @brief records older than a sequence (i.e. the one of the earliest live checkpoint) will not be
+ * restored anymore, each thread drops them from its log when the log grows
+ */
+auto prune_thread_mem_writes (UINT64 before_sequence) -> void
+{
+  pruning_sequence.store(before_sequence);
+  return;
+}
+
+
+/**
+ * @brief restore the addresses written by other threads since a checkpoint: the other threads are
+ * stopped, their logs are merged by the sequence numbers and the original values are restored in
+ * the reverse order (so the value before the first write since the checkpoint is kept).
+ */
+auto restore_thread_mem_writes (THREADID traced_thread, UINT64 since_sequence) -> void
+{
+  // other threads are stopped only if some of them have written since the checkpoint
+  if ((write_sequencer.load() > since_sequence) && PIN_StopApplicationThreads(traced_thread))
+  {
+    mem_write_records_t merged_records;
+    for (UINT32 thread_idx = 0; thread_idx < PIN_GetStoppedThreadCount(); ++thread_idx)
+    {
+      auto log = thread_log(PIN_GetStoppedThreadId(thread_idx));
+      if (log)
+      {
+        // the records of a log are ordered by their sequence numbers
+        auto first_record = std::find_if(log->records.begin(), log->records.end(),
+                                         [&](mem_write_records_t::const_reference record) -> bool
+        {
+          return (record.sequence >= since_sequence);
+        });
+        merged_records.insert(merged_records.end(), first_record, log->records.end());
+        log->records.erase(first_record, log->records.end());
+      }
+    }
+
+    std::sort(merged_records.begin(), merged_records.end(),
+              [](mem_write_records_t::const_reference record_a,
+                 mem_write_records_t::const_reference record_b) -> bool
+    {
+      return (record_a.sequence < record_b.sequence);
+    });
+
+    std::for_each(merged_records.rbegin(), merged_records.rend(),
+                  [](mem_write_records_t::const_reference record)
+    {
+      PIN_SafeCopy(reinterpret_cast<UINT8*>(record.address), &record.original_value, sizeof(UINT8));
+    });
+
+    PIN_ResumeApplicationThreads(traced_thread);
+  }
+  return;
+}
@@ -0,0 +1,34 @@
+#ifndef THREAD_MEMORY_LOG_H
+#define THREAD_MEMORY_LOG_H
+
+#include "../parsing_helper.h"
+#include <pin.H>
+
+#include <vector>
+
+/**
+ * @brief a memory write of some thread (other than the traced one): the original value of the
+ * written address and the global sequence number of the write
+ */
+typedef struct
+{
+  UINT64  sequence;
+  ADDRINT address;
+  UINT8   original_value;
+}                                         mem_write_record_t;
+
+typedef std::vector<mem_write_record_t>   mem_write_records_t;
+
+extern auto initialize_thread_memory_logs   ()                                      -> void;
+
+extern auto current_write_sequence          ()                                      -> UINT64;
+
+extern auto thread_mem_write_tracking       (THREADID thread_id, ADDRINT mem_addr,
+                                             UINT32 mem_length, ADDRINT stack_ptr)  -> void;
+
+extern auto prune_thread_mem_writes         (UINT64 before_sequence)                -> void;
+
+extern auto restore_thread_mem_writes       (THREADID traced_thread,
+                                             UINT64 since_sequence)                 -> void;
+
+#endif // THREAD_MEMORY_LOG_H
@@ -0,0 +1,98 @@
+#include "value_set_label.h"
+
+#include <algorithm>
+#include <boost/functional/hash.hpp>
+
+/*================================================================================================*/
+
+value_set_label::value_set_label () : map_num(0), is_byte_set(true), hash(0)
+{
+}
+
+
+/**
+ * @brief the label of a vector of maps, the values of a map are taken in the order of its addresses
+ * (as in two_maps_are_isomorphic)
+ */
+value_set_label::value_set_label (const addrint_value_maps_t& maps) :
+  map_num(maps.size()), hash(0)
+{
+  this->is_byte_set = std::all_of(std::begin(maps), std::end(maps),
+                                  [](addrint_value_maps_t::const_reference addrs_values)
+  {
+    return (addrs_values.size() == 1);
+  });
+
+  if (this->is_byte_set)
+  {
+    std::for_each(std::begin(maps), std::end(maps),
+                  [&](addrint_value_maps_t::const_reference addrs_values)
+    {
+      this->byte_values.set(std::get<1>(*std::begin(addrs_values)));
+    });
+    this->hash = std::hash<std::bitset<256>>()(this->byte_values);
+  }
+  else
+  {
+    std::for_each(std::begin(maps), std::end(maps),
+                  [&](addrint_value_maps_t::const_reference addrs_values)
+    {
+      auto values = std::vector<UINT8>();
+      std::for_each(std::begin(addrs_values), std::end(addrs_values),
+                    [&values](addrint_value_map_t::const_reference addr_value)
+      {
+        values.push_back(std::get<1>(addr_value));
+      });
+      this->tuple_values.push_back(values);
+    });
+
+    std::sort(std::begin(this->tuple_values), std::end(this->tuple_values));
+    this->tuple_values.erase(std::unique(std::begin(this->tuple_values),
+                                         std::end(this->tuple_values)),
+                             std::end(this->tuple_values));
+    this->hash = boost::hash_range(std::begin(this->tuple_values), std::end(this->tuple_values));
+  }
+  boost::hash_combine(this->hash, this->map_num);
+}
+
+
+/**
+ * @brief two labels are equal iff their vectors of maps are isomorphic, one-byte sets are compared
+ * by a few word operations
+ */
+auto value_set_label::operator== (const value_set_label& other) const -> bool
+{
+  if ((this->hash != other.hash) || (this->map_num != other.map_num) ||
+      (this->is_byte_set != other.is_byte_set)) return false;
+
+  return this->is_byte_set ? (this->byte_values == other.byte_values)
+                           : (this->tuple_values == other.tuple_values);
+}
+
+
+auto value_set_label::operator!= (const value_set_label& other) const -> bool
+{
+  return !(*this == other);
+}
+
+
+/**
+ * @brief a label is included in another if it has less maps and each of its maps is isomorphic
+ * with some map of the other (as in a_vmaps_is_included_in_b)
+ */
+auto value_set_label::is_included_in (const value_set_label& other) const -> bool
+{
+  if ((this->map_num >= other.map_num) || (this->is_byte_set != other.is_byte_set)) return false;
+
+  return this->is_byte_set ? (this->byte_values & ~other.byte_values).none()
+                           : std::includes(std::begin(other.tuple_values),
+                                           std::end(other.tuple_values),
+                                           std::begin(this->tuple_values),
+                                           std::end(this->tuple_values));
+}
+
+
+auto hash_value (const value_set_label& label) -> std::size_t
+{
+  return label.hash;
+}
@@ -0,0 +1,34 @@
+#ifndef VALUE_SET_LABEL_H
+#define VALUE_SET_LABEL_H
+
+#include "cond_direct_instruction.h"
+
+#include <bitset>
+#include <vector>
+
+/**
+ * @brief the canonical form of a vector of maps (e.g. a CFI projection or a DFA transition) up to
+ * isomorphism: only the values of the maps are kept, as a subset of 0-255 (a 256-bit set) when the
+ * maps are of one byte, or as a sorted set of value tuples otherwise
+ */
+class value_set_label
+{
+public:
+  UINT32                          map_num;
+  bool                            is_byte_set;
+  std::bitset<256>                byte_values;
+  std::vector<std::vector<UINT8>> tuple_values;
+  std::size_t                     hash;
+
+public:
+  value_set_label                 ();
+  explicit value_set_label        (const addrint_value_maps_t& maps);
+
+  auto operator==                 (const value_set_label& other) const -> bool;
+  auto operator!=                 (const value_set_label& other) const -> bool;
+  auto is_included_in             (const value_set_label& other) const -> bool;
+};
+
+extern auto hash_value (const value_set_label& label) -> std::size_t;
+
+#endif // VALUE_SET_LABEL_H
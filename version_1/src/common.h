@@ -8,9 +8,14 @@
 #include <random>
 
 #include "base/checkpoint.h"
+#include "base/thread_memory_log.h"
+#include "base/instruction_cache.h"
+#include "base/taint_shadow.h"
 #include "base/cond_direct_instruction.h"
 #include "base/execution_path.h"
 #include "util/tinyformat.h"
+#include "util/event_log.h"
+#include "util/fsa_builder.h"
 #include "base/explorer_graph.h"
 #include "base/execution_dfa.h"
 
@@ -46,7 +51,7 @@ extern ptr_cond_direct_ins_t    exploring_cfi;
 
 extern UINT32                   current_exec_order;
 
-extern path_code_t              current_path_code;
+extern path_code_id_t           current_path_code;
 extern ptr_explorer_graph_t     explored_fsa;
 
 extern ptr_exec_dfa_t           abstracted_dfa;
@@ -78,6 +83,16 @@ extern UINT64                   econed_ins_number;
 extern KNOB<UINT32>             max_total_rollback_knob;
 extern KNOB<UINT32>             max_local_rollback_knob;
 extern KNOB<UINT32>             max_trace_length_knob;
+extern KNOB<FLT64>              giveup_probability_knob;
+extern KNOB<std::string>        instruction_cache_knob;
+extern KNOB<BOOL>               tainting_graph_knob;
+extern KNOB<BOOL>               event_log_knob;
+extern KNOB<BOOL>               bisection_knob;
+extern KNOB<UINT32>             worker_num_knob;
+extern KNOB<std::string>        scheduling_policy_knob;
+extern KNOB<BOOL>               fsa_knob;
+extern KNOB<BOOL>               path_instructions_knob;
+extern KNOB<BOOL>               dfa_minimization_knob;
 
 extern std::ofstream            log_file;
 
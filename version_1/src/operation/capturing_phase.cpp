@@ -47,7 +47,7 @@ static auto prepare_new_tainting_phase() -> void
             reinterpret_cast<UINT8*>(received_msg_addr) + received_msg_size, fresh_input.get());
 
   // switch to the tainting state
-  current_running_phase = tainting_phase; PIN_RemoveInstrumentation();
+  current_running_phase = tainting_phase;
 #if !defined(NDEBUG)
   tfm::format(log_file, "%s\nthe message of order %d saved at %s with size %d bytes\n",
               "================================================================================",
@@ -911,9 +911,9 @@ VOID syscall_exit_analyzer(THREADID thread_id, CONTEXT* p_ctxt, SYSCALL_STANDARD
         received_msg_num++;
         received_msg_addr = logged_syscall_args[1]; received_msg_size = returned_value;
 #if !defined(NDEBUG)
-        tfm::format(log_file, "the first message saved at %s with size %d bytes\nstart tainting \
-                    the first time with trace size %d\n", addrint_to_hexstring(received_msg_addr),
-                    received_msg_size, max_trace_size);
+        tfm::format(log_file, "the first message saved at %s with size %d bytes\n"
+                    "start tainting the first time with trace size %d\n",
+                    addrint_to_hexstring(received_msg_addr), received_msg_size, max_trace_size);
 #endif
         // the first received message is the considered input
         if (received_msg_num == 1)
@@ -935,15 +935,21 @@ VOID syscall_exit_analyzer(THREADID thread_id, CONTEXT* p_ctxt, SYSCALL_STANDARD
 auto mem_read_instruction (ADDRINT ins_addr, ADDRINT r_mem_addr, UINT32 r_mem_size, CONTEXT* p_ctxt,
                            THREADID thread_id) -> VOID
 {
-  if (thread_id == traced_thread_id)
+  // verify if the instruction read some addresses in the input buffer, the reading thread may not
+  // be the receiving one (e.g. the message is handed to a worker thread)
+  if (std::max(r_mem_addr, received_msg_addr) <
+      std::min(r_mem_addr + r_mem_size, received_msg_addr + received_msg_size))
   {
-    // verify if the instruction read some addresses in the input buffer
-    if (std::max(r_mem_addr, received_msg_addr) <
-        std::min(r_mem_addr + r_mem_size, received_msg_addr + received_msg_size))
+    // yes, then the reading thread is traced and the tainting phase starts: the CFIs depending on
+    // the input are executed by the threads reading it, whereas the receiving thread may only hand
+    // the buffer over (the phase starts at this first read, so the traced thread is changed once)
+    if (thread_id != traced_thread_id)
     {
-      // yes, then start the tainting phase
-      prepare_new_tainting_phase(); PIN_ExecuteAt(p_ctxt);
+      tfm::format(log_file, "message is handed from thread id %d to thread id %d, the latter is traced\n",
+                  traced_thread_id, thread_id);
     }
+    traced_thread_id = thread_id;
+    prepare_new_tainting_phase(); PIN_ExecuteAt(p_ctxt);
   }
   return;
 }
@@ -0,0 +1,183 @@
+#include "exploring_scheduler.h"
+#include "../common.h"
+
+#include <queue>
+#include <vector>
+#include <map>
+#include <set>
+#include <ctime>
+#include <algorithm>
+
+/*================================================================================================*/
+
+// a pending CFI with its score when it is queued, CFIs of the same score are explored in the order
+// they are resolved (that is also the order they are detected)
+struct scheduled_cfi_t
+{
+  FLT64                 score;
+  UINT32                resolved_order;
+  ptr_cond_direct_ins_t cfi;
+
+  auto operator< (const scheduled_cfi_t& other) const -> bool
+  {
+    // std::priority_queue pops the greatest element, so the lower score is the greater element
+    return (this->score > other.score) ||
+        ((this->score == other.score) && (this->resolved_order > other.resolved_order));
+  }
+};
+
+// coverage of the exploration when a new CFI is explored
+struct scheduling_stat_t
+{
+  time_t  elapsed_time;
+  UINT32  used_rollback_num;
+  UINT32  explored_cfi_num;
+  UINT32  explored_cfi_addr_num;
+  UINT32  covered_ins_num;
+};
+
+static std::map<std::string, cfi_scorer_t>  scorer_of_policy;
+static std::string                          active_policy;
+static cfi_scorer_t                         active_scorer;
+
+static std::priority_queue<scheduled_cfi_t> pending_cfis;
+static UINT32                               resolved_cfi_num;
+static UINT32                               explored_cfi_num;
+static std::map<ADDRINT, UINT32>            explored_num_at_addr;
+
+static std::vector<scheduling_stat_t>       scheduling_stats;
+static time_t                               scheduling_start_time;
+
+/*================================================================================================*/
+
+/**
+ * @brief builtin policies: "order" is the detection order (i.e. depth-first), "novelty" prefers
+ * CFIs whose static address is explored the least, "depth" prefers the shortest path code (i.e.
+ * breadth-first), "width" prefers CFIs depending on the most input bytes. A user heuristic of
+ * the same name is kept.
+ */
+static auto add_builtin_policies () -> void
+{
+  auto add_builtin_policy = [](const std::string& policy_name, cfi_scorer_t cfi_scorer) -> void
+  {
+    scorer_of_policy.insert(std::make_pair(policy_name, cfi_scorer));
+  };
+
+  add_builtin_policy("order", [](const ptr_cond_direct_ins_t& cfi) -> FLT64
+  {
+    return 0;
+  });
+
+  add_builtin_policy("novelty", [](const ptr_cond_direct_ins_t& cfi) -> FLT64
+  {
+    auto explored_iter = explored_num_at_addr.find(cfi->address);
+    return (explored_iter != explored_num_at_addr.end()) ? std::get<1>(*explored_iter) : 0;
+  });
+
+  add_builtin_policy("depth", [](const ptr_cond_direct_ins_t& cfi) -> FLT64
+  {
+    return path_code_length(cfi->path_code);
+  });
+
+  add_builtin_policy("width", [](const ptr_cond_direct_ins_t& cfi) -> FLT64
+  {
+    return -static_cast<FLT64>(cfi->input_dep_addrs.size());
+  });
+  return;
+}
+
+
+/**
+ * @brief add (or replace) a scheduling policy, user heuristics are added before the scheduler is
+ * initialized
+ */
+auto add_scheduling_policy (const std::string& policy_name, cfi_scorer_t cfi_scorer) -> void
+{
+  scorer_of_policy[policy_name] = cfi_scorer;
+  return;
+}
+
+
+/**
+ * @brief initialize_scheduler, return false if the policy does not exist
+ */
+auto initialize_scheduler (const std::string& policy_name) -> bool
+{
+  add_builtin_policies();
+
+  auto policy_iter = scorer_of_policy.find(policy_name);
+  if (policy_iter == scorer_of_policy.end()) return false;
+
+  active_policy = policy_name; active_scorer = std::get<1>(*policy_iter);
+  pending_cfis = decltype(pending_cfis)(); resolved_cfi_num = 0; explored_cfi_num = 0;
+  explored_num_at_addr.clear(); scheduling_stats.clear();
+  scheduling_start_time = std::time(0);
+  return true;
+}
+
+
+/**
+ * @brief schedule a newly resolved CFI
+ */
+auto schedule_cfi (ptr_cond_direct_ins_t resolved_cfi) -> void
+{
+  scheduled_cfi_t scheduled_cfi = { active_scorer(resolved_cfi), resolved_cfi_num++, resolved_cfi };
+  pending_cfis.push(scheduled_cfi);
+  return;
+}
+
+
+/**
+ * @brief pop the pending CFI of the lowest score, return an empty pointer if there is no pending
+ * CFI. Scores may increase while CFIs are pending (e.g. the novelty of an address decreases once
+ * it is explored), so a CFI whose score has increased is queued again with the new score.
+ */
+auto next_scheduled_cfi () -> ptr_cond_direct_ins_t
+{
+  ptr_cond_direct_ins_t next_cfi;
+  while (!pending_cfis.empty() && !next_cfi)
+  {
+    auto scheduled_cfi = pending_cfis.top(); pending_cfis.pop();
+
+    auto current_score = active_scorer(scheduled_cfi.cfi);
+    if (current_score > scheduled_cfi.score)
+    {
+      scheduled_cfi.score = current_score; pending_cfis.push(scheduled_cfi);
+    }
+    else next_cfi = scheduled_cfi.cfi;
+  }
+
+  if (next_cfi)
+  {
+    explored_num_at_addr[next_cfi->address]++; explored_cfi_num++;
+
+    scheduling_stat_t current_stat = { std::time(0) - scheduling_start_time, total_rollback_times,
+                                       explored_cfi_num,
+                                       static_cast<UINT32>(explored_num_at_addr.size()),
+                                       static_cast<UINT32>(ins_at_addr.size()) };
+    scheduling_stats.push_back(current_stat);
+  }
+
+  return next_cfi;
+}
+
+
+/**
+ * @brief save the coverage over time of the active policy, one line per explored CFI
+ */
+auto save_scheduling_statistics (const std::string& filename) -> void
+{
+  std::ofstream stat_file(filename.c_str(), std::ofstream::out | std::ofstream::trunc);
+
+  tfm::format(stat_file, "# policy %s\n", active_policy);
+  tfm::format(stat_file, "# seconds rollbacks explored_cfis explored_cfi_addresses covered_instructions\n");
+  std::for_each(scheduling_stats.begin(), scheduling_stats.end(),
+                [&stat_file](decltype(scheduling_stats)::const_reference stat)
+  {
+    tfm::format(stat_file, "%d %d %d %d %d\n", stat.elapsed_time, stat.used_rollback_num,
+                stat.explored_cfi_num, stat.explored_cfi_addr_num, stat.covered_ins_num);
+  });
+
+  stat_file.close();
+  return;
+}
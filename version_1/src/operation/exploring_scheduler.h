@@ -0,0 +1,24 @@
+#ifndef EXPLORING_SCHEDULER_H
+#define EXPLORING_SCHEDULER_H
+
+#include "../parsing_helper.h"
+#include "../base/cond_direct_instruction.h"
+
+#include <string>
+#include <functional>
+
+// a scheduling heuristic scores a resolved CFI, the CFI of the lowest score is explored first
+typedef std::function<FLT64(const ptr_cond_direct_ins_t&)> cfi_scorer_t;
+
+extern auto initialize_scheduler        (const std::string& policy_name)  -> bool;
+
+extern auto add_scheduling_policy       (const std::string& policy_name,
+                                         cfi_scorer_t cfi_scorer)          -> void;
+
+extern auto schedule_cfi                (ptr_cond_direct_ins_t resolved_cfi) -> void;
+
+extern auto next_scheduled_cfi          ()                                -> ptr_cond_direct_ins_t;
+
+extern auto save_scheduling_statistics  (const std::string& filename)     -> void;
+
+#endif // EXPLORING_SCHEDULER_H
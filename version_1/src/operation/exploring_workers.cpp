@@ -0,0 +1,778 @@
+#include "exploring_workers.h"
+#include "exploring_scheduler.h"
+#include "../common.h"
+#include "../util/stuffs.h"
+
+#include <sstream>
+#include <vector>
+#include <set>
+#include <map>
+#include <algorithm>
+
+#if defined(__gnu_linux__)
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#endif
+
+/*================================================================================================*/
+
+// with -w <n> (n > 1) the process exploring the first trace forks n workers once the rollbacking
+// phase of the first trace is done, then it becomes their coordinator: it keeps the queue of
+// pending CFIs and hands them out one at a time to workers requesting a new CFI; a worker sends
+// back the instructions, the CFIs, the FSA updates and the path of each explored CFI, so the DFA
+// and the explored FSA are built by the coordinator as in a single process. Messages are framed
+// as "<payload size>\n<payload>" over a socket pair per worker.
+static UINT32 worker_number = 1;
+
+#if defined(__gnu_linux__)
+
+typedef enum
+{
+  busy_worker     = 0,  // is exploring a CFI (or starting)
+  waiting_worker  = 1,  // has requested a new CFI
+  stopped_worker  = 2   // has been stopped or is lost
+}                               worker_state;
+
+typedef struct
+{
+  pid_t         pid;
+  INT           channel;
+  worker_state  state;
+  std::string   received_bytes;
+} worker_t;
+
+static std::vector<worker_t>    workers;
+static bool                     workers_are_forked = false;
+
+// a worker sends only instructions and CFIs that the coordinator does not know yet
+static bool                     in_forked_worker = false;
+static INT                      coordinator_channel = -1;
+static std::string              coordinator_bytes;
+static std::set<ADDRINT>        sent_ins_addrs;
+static size_t                   sent_cfi_num = 0;
+static UINT32                   reported_rollback_times = 0;
+
+/*================================================================================================*/
+
+/**
+ * @brief path codes are sent as strings of bits (ids of codes are local to a process), "-" is the
+ * empty code
+ */
+static auto path_code_to_message (path_code_id_t code) -> std::string
+{
+  return (code == empty_path_code) ? std::string("-") : path_code_to_string(path_code_bits(code));
+}
+
+
+static auto path_code_from_message (const std::string& code_str) -> path_code_id_t
+{
+  auto code = empty_path_code;
+  if (code_str != "-")
+  {
+    std::for_each(code_str.begin(), code_str.end(), [&](char code_bit)
+    {
+      code = extended_path_code(code, code_bit == '1');
+    });
+  }
+  return code;
+}
+
+
+/**
+ * @brief an instruction is described by "ins <address> <is CFI> <name> <image> <function>",
+ * fields are separated by tabs
+ */
+static auto write_instruction (std::ostream& message, const instruction& ins) -> void
+{
+  tfm::format(message, "ins\t%d\t%d\t%s\t%s\t%s\n", ins.address, ins.is_cond_direct_cf ? 1 : 0,
+              ins.disassembled_name, ins.contained_image, ins.contained_function);
+  return;
+}
+
+
+static auto read_instruction (const std::string& ins_line) -> ptr_instruction_t
+{
+  std::istringstream fields(ins_line);
+  std::string kind, addr_str, cf_str;
+  auto read_ins = std::make_shared<instruction>();
+  std::getline(fields, kind, '\t'); std::getline(fields, addr_str, '\t');
+  std::getline(fields, cf_str, '\t'); std::getline(fields, read_ins->disassembled_name, '\t');
+  std::getline(fields, read_ins->contained_image, '\t');
+  std::getline(fields, read_ins->contained_function, '\t');
+
+  std::istringstream(addr_str) >> read_ins->address;
+  read_ins->is_cond_direct_cf = (cf_str == "1");
+  return read_ins->is_cond_direct_cf ?
+        std::make_shared<cond_direct_instruction>(*read_ins) : read_ins;
+}
+
+
+static auto write_maps (std::ostream& message, const addrint_value_maps_t& addr_value_maps) -> void
+{
+  std::for_each(addr_value_maps.begin(), addr_value_maps.end(),
+                [&](addrint_value_maps_t::const_reference addr_value)
+  {
+    tfm::format(message, "map");
+    std::for_each(addr_value.begin(), addr_value.end(),
+                  [&](addrint_value_map_t::const_reference addr_val)
+    {
+      tfm::format(message, " %d %d", std::get<0>(addr_val),
+                  static_cast<UINT32>(std::get<1>(addr_val)));
+    });
+    tfm::format(message, "\n");
+  });
+  return;
+}
+
+
+static auto read_maps (std::istream& message, UINT32 map_num) -> addrint_value_maps_t
+{
+  addrint_value_maps_t addr_value_maps;
+  std::string map_line, kind;
+  for (UINT32 map_idx = 0; (map_idx < map_num) && std::getline(message, map_line); ++map_idx)
+  {
+    std::istringstream fields(map_line); fields >> kind;
+
+    auto addr_value = addrint_value_map_t(); ADDRINT addr; UINT32 value;
+    while (fields >> addr >> value) addr_value[addr] = static_cast<UINT8>(value);
+    addr_value_maps.push_back(addr_value);
+  }
+  return addr_value_maps;
+}
+
+
+/**
+ * @brief a CFI instance is described by
+ *    "cfi <address> <order> <path code> <resolved> <bypassed> <singular> <used rollbacks>
+ *         <number of first projections> <number of second projections>"
+ * followed by a line of its input dependent addresses, a line of its (hexadecimal) input, and a
+ * line per projection; the sent projections are given since a CFI handed out to a worker needs
+ * only the first one of its second projections
+ */
+static auto write_cfi (std::ostream& message, const ptr_cond_direct_ins_t& cfi,
+                       const addrint_value_maps_t& first_projections,
+                       const addrint_value_maps_t& second_projections) -> void
+{
+  tfm::format(message, "cfi %d %d %s %d %d %d %d %d %d\n", cfi->address, cfi->exec_order,
+              path_code_to_message(cfi->path_code), cfi->is_resolved ? 1 : 0,
+              cfi->is_bypassed ? 1 : 0, cfi->is_singular ? 1 : 0, cfi->used_rollback_num,
+              first_projections.size(), second_projections.size());
+
+  tfm::format(message, "deps");
+  std::for_each(cfi->input_dep_addrs.begin(), cfi->input_dep_addrs.end(), [&](ADDRINT dep_addr)
+  {
+    tfm::format(message, " %d", dep_addr);
+  });
+
+  tfm::format(message, "\ninput ");
+  if (cfi->fresh_input)
+  {
+    for (UINT32 offset = 0; offset < cfi->fresh_input->size; ++offset)
+    {
+      tfm::format(message, "%02x", static_cast<UINT32>(cfi->fresh_input->byte_at(offset)));
+    }
+  }
+  tfm::format(message, "\n");
+
+  write_maps(message, first_projections); write_maps(message, second_projections);
+  return;
+}
+
+
+/**
+ * @brief rebuild a CFI instance from its description, the instruction is the one at its address
+ */
+static auto read_cfi (std::istream& message, const std::string& cfi_line,
+                      instruction& cfi_ins) -> ptr_cond_direct_ins_t
+{
+  auto cfi = std::make_shared<cond_direct_instruction>(cfi_ins);
+
+  std::istringstream fields(cfi_line);
+  std::string kind, code_str;
+  UINT32 is_resolved, is_bypassed, is_singular, first_num, second_num;
+  fields >> kind >> cfi->address >> cfi->exec_order >> code_str >> is_resolved >> is_bypassed
+         >> is_singular >> cfi->used_rollback_num >> first_num >> second_num;
+  cfi->path_code = path_code_from_message(code_str);
+  cfi->is_resolved = (is_resolved != 0); cfi->is_bypassed = (is_bypassed != 0);
+  cfi->is_singular = (is_singular != 0);
+
+  std::string line;
+  std::getline(message, line);
+  std::istringstream dep_fields(line); dep_fields >> kind;
+  ADDRINT dep_addr;
+  while (dep_fields >> dep_addr) cfi->input_dep_addrs.insert(dep_addr);
+
+  std::getline(message, line);
+  auto input_bytes = std::vector<UINT8>();
+  for (size_t char_idx = std::string("input ").size(); char_idx + 1 < line.size(); char_idx += 2)
+  {
+    input_bytes.push_back(static_cast<UINT8>(std::stoul(line.substr(char_idx, 2), 0, 16)));
+  }
+  if (!input_bytes.empty())
+  {
+    cfi->fresh_input = intern_input(&input_bytes[0], static_cast<UINT32>(input_bytes.size()));
+  }
+
+  cfi->first_input_projections = read_maps(message, first_num);
+  cfi->second_input_projections = read_maps(message, second_num);
+  return cfi;
+}
+
+
+/**
+ * @brief the instance of the instruction at an address executed at an order, a CFI is copied so
+ * that its instances are distinct; return an empty pointer if the address is unknown
+ */
+static auto instance_at (ADDRINT ins_addr, UINT32 ins_order) -> ptr_instruction_t
+{
+  ptr_instruction_t ins;
+  auto ins_iter = ins_at_addr.find(ins_addr);
+  if (ins_iter != ins_at_addr.end())
+  {
+    if (std::get<1>(*ins_iter)->is_cond_direct_cf)
+    {
+      auto cfi = std::make_shared<cond_direct_instruction>(*std::get<1>(*ins_iter));
+      cfi->exec_order = ins_order; ins = cfi;
+    }
+    else ins = std::get<1>(*ins_iter);
+  }
+  return ins;
+}
+
+/*================================================================================================*/
+
+static auto send_message (INT channel, const std::string& payload) -> bool
+{
+  auto frame = tfm::format("%d\n", payload.size()) + payload;
+  size_t sent_size = 0;
+  while (sent_size < frame.size())
+  {
+    auto sent_part = send(channel, frame.data() + sent_size, frame.size() - sent_size,
+                          MSG_NOSIGNAL);
+    if (sent_part < 0)
+    {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    sent_size += sent_part;
+  }
+  return true;
+}
+
+
+/**
+ * @brief append the available bytes of a channel, return false at the end of the channel
+ */
+static auto receive_bytes (INT channel, std::string& received_bytes) -> bool
+{
+  char buffer[1 << 16];
+  while (true)
+  {
+    auto received_size = read(channel, buffer, sizeof(buffer));
+    if (received_size > 0)
+    {
+      received_bytes.append(buffer, received_size); return true;
+    }
+    if ((received_size < 0) && (errno == EINTR)) continue;
+    return false;
+  }
+}
+
+
+/**
+ * @brief take the first complete message of the received bytes
+ */
+static auto take_message (std::string& received_bytes, std::string& payload) -> bool
+{
+  auto header_end = received_bytes.find('\n');
+  if (header_end == std::string::npos) return false;
+
+  size_t payload_size = 0;
+  std::istringstream(received_bytes.substr(0, header_end)) >> payload_size;
+  if (received_bytes.size() < header_end + 1 + payload_size) return false;
+
+  payload = received_bytes.substr(header_end + 1, payload_size);
+  received_bytes.erase(0, header_end + 1 + payload_size);
+  return true;
+}
+
+/*================================================================================================*/
+
+/**
+ * @brief a worker asks the coordinator for a new CFI, it reports also the rollbacks used since its
+ * last request; return an empty pointer if the worker is stopped
+ */
+static auto requested_cfi () -> ptr_cond_direct_ins_t
+{
+  ptr_cond_direct_ins_t next_cfi;
+
+  auto request = tfm::format("request %d\n", total_rollback_times - reported_rollback_times);
+  reported_rollback_times = total_rollback_times;
+  if (!send_message(coordinator_channel, request)) return next_cfi;
+
+  std::string task;
+  while (!take_message(coordinator_bytes, task))
+  {
+    if (!receive_bytes(coordinator_channel, coordinator_bytes)) return next_cfi;
+  }
+
+  std::istringstream task_lines(task);
+  std::string kind_line, ins_line, cfi_line;
+  std::getline(task_lines, kind_line);
+  if ((kind_line == "explore") && std::getline(task_lines, ins_line) &&
+      std::getline(task_lines, cfi_line))
+  {
+    // the instruction is not examined by this worker if the CFI is detected by another one, it is
+    // then kept out of the examined instructions (they are added only by the instrumentation)
+    auto cfi_ins = read_instruction(ins_line);
+    auto received_cfi = read_cfi(task_lines, cfi_line, *cfi_ins);
+
+    next_cfi = look_for_saved_instance(received_cfi->address, received_cfi->exec_order,
+                                       received_cfi->path_code);
+    if (!next_cfi)
+    {
+      next_cfi = received_cfi; index_saved_instance(next_cfi);
+    }
+  }
+  return next_cfi;
+}
+
+
+/**
+ * @brief the worker starts with its own log, the coordinator knows already all instructions and
+ * CFIs examined before the fork
+ */
+static auto start_worker (INT channel) -> void
+{
+  in_forked_worker = true; coordinator_channel = channel; workers.clear();
+
+  process_id      = getpid();
+  process_id_str  = std::to_string(static_cast<long long>(process_id));
+  log_file.close();
+  log_file.open(process_id_str + "_path_explorer.log", std::ofstream::out | std::ofstream::trunc);
+
+  sent_ins_addrs.clear();
+  std::for_each(ins_at_addr.begin(), ins_at_addr.end(),
+                [&](addr_ins_map_t::const_reference addr_ins)
+  {
+    sent_ins_addrs.insert(std::get<0>(addr_ins));
+  });
+  sent_cfi_num = detected_input_dep_cfis.size();
+  reported_rollback_times = total_rollback_times;
+  return;
+}
+
+
+/**
+ * @brief fork the workers, the FSA updates and the logged events are flushed before so that they
+ * are not duplicated (internal threads of the tool are not duplicated by fork)
+ */
+static auto fork_workers () -> void
+{
+  tfm::format(log_file, "fork %d exploring workers\n", worker_number);
+  log_file.flush(); std::cout.flush(); std::cerr.flush();
+  close_event_log(); hold_fsa_events();
+
+  for (UINT32 worker_idx = 0; worker_idx < worker_number; ++worker_idx)
+  {
+    INT channels[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, channels) != 0) break;
+    fcntl(channels[0], F_SETFD, FD_CLOEXEC); fcntl(channels[1], F_SETFD, FD_CLOEXEC);
+
+    auto worker_pid = fork();
+    if (worker_pid == 0)
+    {
+      close(channels[0]);
+      std::for_each(workers.begin(), workers.end(), [](const worker_t& worker)
+      {
+        close(worker.channel);
+      });
+      release_fsa_events(true); start_worker(channels[1]);
+      return;
+    }
+
+    close(channels[1]);
+    if (worker_pid < 0)
+    {
+      close(channels[0]); break;
+    }
+    worker_t new_worker = { worker_pid, channels[0], busy_worker, std::string() };
+    workers.push_back(new_worker);
+  }
+
+  release_fsa_events(false);
+  return;
+}
+
+/*================================================================================================*/
+
+/**
+ * @brief add the explored results of a worker: unknown instructions, new CFIs (resolved ones are
+ * scheduled), FSA updates and the explored path; instances in FSA updates are numbered in the
+ * message, a saved CFI instance is the one of the coordinator
+ */
+static auto add_worker_results (std::istream& results) -> void
+{
+  std::map<UINT32, ptr_instruction_t> ins_at_serial;
+  auto referred_instance = [&](std::istream& fields) -> ptr_instruction_t
+  {
+    UINT32 serial, ins_order, is_saved; ADDRINT ins_addr; std::string code_str;
+    fields >> serial >> ins_addr >> ins_order >> is_saved >> code_str;
+
+    auto serial_iter = ins_at_serial.find(serial);
+    if (serial_iter != ins_at_serial.end()) return std::get<1>(*serial_iter);
+
+    ptr_instruction_t ins;
+    if (is_saved)
+      ins = look_for_saved_instance(ins_addr, ins_order, path_code_from_message(code_str));
+    if (!ins)
+    {
+      ins = instance_at(ins_addr, ins_order);
+      if (ins && !ins->is_cond_direct_cf) ins = std::make_shared<instruction>(*ins);
+    }
+    ins_at_serial[serial] = ins;
+    return ins;
+  };
+
+  std::string line, kind;
+  while (std::getline(results, line))
+  {
+    std::istringstream fields(line); fields >> kind;
+
+    if (kind == "ins")
+    {
+      auto new_ins = read_instruction(line);
+      ins_at_addr.insert(std::make_pair(new_ins->address, new_ins));
+    }
+    else if (kind == "cfi")
+    {
+      // the instruction of the CFI has been sent before if it is not known yet
+      ADDRINT cfi_addr; fields >> cfi_addr;
+      auto ins_iter = ins_at_addr.find(cfi_addr);
+      auto cfi_ins = (ins_iter != ins_at_addr.end()) ? std::get<1>(*ins_iter)
+                                                     : std::make_shared<instruction>();
+      auto new_cfi = read_cfi(results, line, *cfi_ins);
+
+      detected_input_dep_cfis.push_back(new_cfi); index_saved_instance(new_cfi);
+      if (new_cfi->is_resolved) schedule_cfi(new_cfi);
+    }
+    else if (kind == "fsa")
+    {
+      UINT32 event_type, event_phase; std::string code_str;
+      fields >> event_type >> event_phase >> code_str;
+
+      fsa_event_t event = { static_cast<fsa_event_type>(event_type), 0, 0, ptr_instruction_t(),
+                            ptr_instruction_t(), path_code_from_message(code_str), event_phase };
+      switch (event.type)
+      {
+      case addr_vertex_event:
+        fields >> event.ins_a_addr; break;
+
+      case ins_vertex_event:
+        event.ins_a = referred_instance(fields); break;
+
+      case addr_edge_event:
+        fields >> event.ins_a_addr >> event.ins_b_addr; break;
+
+      case ins_edge_event:
+        event.ins_a = referred_instance(fields); event.ins_b = referred_instance(fields); break;
+      }
+
+      if ((event.type == addr_vertex_event) || (event.type == addr_edge_event) ||
+          (event.ins_a && ((event.type == ins_vertex_event) || event.ins_b)))
+      {
+        post_fsa_event(event);
+      }
+    }
+    else if (kind == "path")
+    {
+      std::string code_str; UINT32 ins_num, ins_order; ADDRINT ins_addr;
+      fields >> code_str >> ins_num;
+
+      auto path = order_ins_map_t();
+      for (UINT32 ins_idx = 0; (ins_idx < ins_num) && (fields >> ins_order >> ins_addr); ++ins_idx)
+      {
+        auto ins = instance_at(ins_addr, ins_order);
+        if (ins) path[ins_order] = ins;
+      }
+
+      // the path is inserted into the DFA as in a single process
+      auto exec_path = std::make_shared<execution_path>(path, path_code_from_message(code_str));
+      explored_exec_paths.push_back(exec_path);
+      exec_path->calculate_condition(); abstracted_dfa->add_exec_path(exec_path);
+      show_exploring_progress();
+    }
+  }
+  return;
+}
+
+
+/**
+ * @brief hand out pending CFIs to waiting workers; a waiting worker is stopped if the rollback
+ * budget is used up, or if no CFI is pending and no other worker may resolve a new one
+ */
+static auto dispatch_pending_cfis () -> void
+{
+  auto some_worker_is_busy = std::any_of(workers.begin(), workers.end(), [](const worker_t& worker)
+  {
+    return (worker.state == busy_worker);
+  });
+
+  std::for_each(workers.begin(), workers.end(), [&](worker_t& worker)
+  {
+    if (worker.state != waiting_worker) return;
+
+    auto next_cfi = (total_rollback_times < max_total_rollback_times) ? next_scheduled_cfi()
+                                                                      : ptr_cond_direct_ins_t();
+    if (next_cfi)
+    {
+      next_cfi->is_explored = true;
+
+      std::ostringstream task;
+      tfm::format(task, "explore\n"); write_instruction(task, *next_cfi);
+      write_cfi(task, next_cfi, addrint_value_maps_t(),
+                addrint_value_maps_t(1, next_cfi->second_input_projections[0]));
+      if (send_message(worker.channel, task.str()))
+      {
+#if !defined(NDEBUG)
+        tfm::format(log_file, "the worker %d explores the CFI %s at %d\n", worker.pid,
+                    next_cfi->disassembled_name, next_cfi->exec_order);
+#endif
+        worker.state = busy_worker; some_worker_is_busy = true;
+      }
+      else
+      {
+        // the worker is lost, the CFI is handed out to another worker
+        next_cfi->is_explored = false; schedule_cfi(next_cfi);
+        close(worker.channel); worker.state = stopped_worker;
+      }
+    }
+    else if ((total_rollback_times >= max_total_rollback_times) || !some_worker_is_busy)
+    {
+      send_message(worker.channel, "stop\n");
+      close(worker.channel); worker.state = stopped_worker;
+    }
+  });
+  return;
+}
+
+
+/**
+ * @brief the coordinator serves workers until all of them are stopped
+ */
+static auto serve_workers () -> void
+{
+  auto worker_is_running = [](const worker_t& worker) -> bool
+  {
+    return (worker.state != stopped_worker);
+  };
+
+  while (std::any_of(workers.begin(), workers.end(), worker_is_running))
+  {
+    std::vector<pollfd> polled_channels;
+    std::vector<worker_t*> polled_workers;
+    std::for_each(workers.begin(), workers.end(), [&](worker_t& worker)
+    {
+      if (!worker_is_running(worker)) return;
+      pollfd polled_channel = { worker.channel, POLLIN, 0 };
+      polled_channels.push_back(polled_channel); polled_workers.push_back(&worker);
+    });
+
+    if (poll(&polled_channels[0], polled_channels.size(), -1) < 0)
+    {
+      if (errno == EINTR) continue;
+      break;
+    }
+
+    for (size_t polled_idx = 0; polled_idx < polled_channels.size(); ++polled_idx)
+    {
+      if (polled_channels[polled_idx].revents == 0) continue;
+
+      auto& worker = *polled_workers[polled_idx];
+      if (!receive_bytes(worker.channel, worker.received_bytes))
+      {
+        // the worker has exited before being stopped, its exploring CFI is lost
+        tfm::format(log_file, "the worker %d is lost\n", worker.pid);
+        close(worker.channel); worker.state = stopped_worker; continue;
+      }
+
+      std::string payload;
+      while (take_message(worker.received_bytes, payload))
+      {
+        std::istringstream payload_lines(payload);
+        std::string kind; payload_lines >> kind;
+        if (kind == "request")
+        {
+          UINT32 used_rollback_num = 0; payload_lines >> used_rollback_num;
+          total_rollback_times += used_rollback_num; worker.state = waiting_worker;
+        }
+        else if (kind == "results")
+        {
+          std::string rest_of_line; std::getline(payload_lines, rest_of_line);
+          add_worker_results(payload_lines);
+        }
+      }
+    }
+
+    dispatch_pending_cfis();
+  }
+
+  std::for_each(workers.begin(), workers.end(), [](const worker_t& worker)
+  {
+    waitpid(worker.pid, 0, 0);
+  });
+  return;
+}
+
+#endif
+
+/*================================================================================================*/
+
+/**
+ * @brief initialize_workers, exploring workers are supported only on Linux
+ */
+auto initialize_workers (UINT32 worker_num) -> bool
+{
+  if (worker_num == 0) return false;
+#if !defined(__gnu_linux__)
+  if (worker_num > 1) return false;
+#endif
+
+  worker_number = worker_num;
+  return true;
+}
+
+
+auto parallel_exploring () -> bool
+{
+  return (worker_number > 1);
+}
+
+
+auto is_exploring_worker () -> bool
+{
+#if defined(__gnu_linux__)
+  return in_forked_worker;
+#else
+  return false;
+#endif
+}
+
+
+/**
+ * @brief next_exploring_cfi: in a single process, it is the next scheduled CFI. In parallel, the
+ * workers are forked at the first call: a worker requests then its CFIs from the coordinator, the
+ * coordinator serves the workers until the exploration stops and returns an empty pointer.
+ */
+auto next_exploring_cfi () -> ptr_cond_direct_ins_t
+{
+#if defined(__gnu_linux__)
+  if (in_forked_worker) return requested_cfi();
+
+  if (parallel_exploring() && !workers_are_forked)
+  {
+    workers_are_forked = true; fork_workers();
+    if (in_forked_worker) return requested_cfi();
+
+    if (!workers.empty())
+    {
+      serve_workers(); return ptr_cond_direct_ins_t();
+    }
+
+    // no worker is forked, the exploration continues in this process
+    tfm::format(std::cerr, "cannot fork exploring workers, continue in a single process\n");
+    worker_number = 1;
+  }
+#endif
+
+  return next_scheduled_cfi();
+}
+
+
+/**
+ * @brief send_explored_path: a worker sends the results of its last explored CFI
+ *    "ins" lines for the instructions not sent yet,
+ *    "cfi" descriptions (see write_cfi) of the CFIs detected since the last sending,
+ *    "fsa <type> <phase> <path code> <address or instance>..." lines for the FSA updates, where
+ *        an instance is "<number> <address> <order> <is saved> <path code>",
+ *    "path <path code> <number of instructions> <order> <address>..." for the explored path.
+ */
+auto send_explored_path (const ptr_exec_path_t& exec_path) -> void
+{
+#if defined(__gnu_linux__)
+  std::ostringstream results;
+  tfm::format(results, "results\n");
+
+  std::for_each(ins_at_addr.begin(), ins_at_addr.end(),
+                [&](addr_ins_map_t::const_reference addr_ins)
+  {
+    if (sent_ins_addrs.insert(std::get<0>(addr_ins)).second)
+      write_instruction(results, *std::get<1>(addr_ins));
+  });
+
+  for (; sent_cfi_num < detected_input_dep_cfis.size(); ++sent_cfi_num)
+  {
+    auto new_cfi = detected_input_dep_cfis[sent_cfi_num];
+    write_cfi(results, new_cfi, new_cfi->first_input_projections,
+              new_cfi->second_input_projections);
+  }
+
+  std::map<const instruction*, UINT32> serial_of_ins;
+  auto write_instance = [&](const ptr_instruction_t& ins) -> void
+  {
+    auto new_serial = static_cast<UINT32>(serial_of_ins.size());
+    auto serial = serial_of_ins.insert(std::make_pair(ins.get(), new_serial)).first->second;
+    UINT32 ins_order = 0; auto is_saved = false; auto ins_code = empty_path_code;
+    if (ins->is_cond_direct_cf)
+    {
+      auto cfi = std::static_pointer_cast<cond_direct_instruction>(ins);
+      ins_order = cfi->exec_order; ins_code = cfi->path_code;
+      is_saved = (look_for_saved_instance(cfi, cfi->path_code) == cfi);
+    }
+    tfm::format(results, " %d %d %d %d %s", serial, ins->address, ins_order, is_saved ? 1 : 0,
+                path_code_to_message(ins_code));
+    return;
+  };
+
+  auto taken_events = taken_fsa_events();
+  std::for_each(taken_events.begin(), taken_events.end(), [&](fsa_events_t::const_reference event)
+  {
+    tfm::format(results, "fsa %d %d %s", static_cast<UINT32>(event.type), event.phase,
+                path_code_to_message(event.path_code));
+    switch (event.type)
+    {
+    case addr_vertex_event:
+      tfm::format(results, " %d", event.ins_a_addr); break;
+
+    case ins_vertex_event:
+      write_instance(event.ins_a); break;
+
+    case addr_edge_event:
+      tfm::format(results, " %d %d", event.ins_a_addr, event.ins_b_addr); break;
+
+    case ins_edge_event:
+      write_instance(event.ins_a); write_instance(event.ins_b); break;
+    }
+    tfm::format(results, "\n");
+  });
+
+  auto path_ins = exec_path->instructions();
+  tfm::format(results, "path %s %d", path_code_to_message(exec_path->code), path_ins.size());
+  std::for_each(path_ins.begin(), path_ins.end(), [&](order_ins_map_t::const_reference order_ins)
+  {
+    tfm::format(results, " %d %d", std::get<0>(order_ins), std::get<1>(order_ins)->address);
+  });
+  tfm::format(results, "\n");
+
+  if (!send_message(coordinator_channel, results.str()))
+  {
+    tfm::format(log_file, "cannot send the explored path to the coordinator\n");
+  }
+#endif
+  return;
+}
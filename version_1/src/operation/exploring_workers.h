@@ -0,0 +1,18 @@
+#ifndef EXPLORING_WORKERS_H
+#define EXPLORING_WORKERS_H
+
+#include "../parsing_helper.h"
+#include "../base/cond_direct_instruction.h"
+#include "../base/execution_path.h"
+
+extern auto initialize_workers        (UINT32 worker_num)                       -> bool;
+
+extern auto parallel_exploring        ()                                        -> bool;
+
+extern auto is_exploring_worker       ()                                        -> bool;
+
+extern auto next_exploring_cfi        ()                                        -> ptr_cond_direct_ins_t;
+
+extern auto send_explored_path        (const ptr_exec_path_t& exec_path)        -> void;
+
+#endif // EXPLORING_WORKERS_H
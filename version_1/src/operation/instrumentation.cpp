@@ -11,6 +11,7 @@
 #include "capturing_phase.h"
 #include "tainting_phase.h"
 #include "rollbacking_phase.h"
+#include "../base/instruction_cache.h"
 
 namespace instrumentation
 {
@@ -18,6 +19,10 @@ typedef std::function</*void(RTN&)*/capturing::interceptor_t> instrument_func_t;
 static std::map<std::string, instrument_func_t> intercept_func_of_name;
 static std::map<std::string, instrument_func_t> replace_func_of_name;
 
+// each running phase is instrumented in its own version of traces (the version is the value of the
+// phase), the register holds the current phase at the entry of traces
+static REG phase_reg;
+
 /**
  * @brief exec_capturing_phase
  */
@@ -27,18 +32,23 @@ static auto exec_capturing_phase (INS& ins) -> void
 //  INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)capturing::generic_instruction,
 //                           IARG_INST_PTR, IARG_THREAD_ID, IARG_END);
 
-  // waiting for some instruction accessing the message buffer
+  // waiting for some instruction accessing the message buffer (the context is passed only when
+  // the message is read)
   if (INS_IsMemoryRead(ins))
   {
-    INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)capturing::mem_read_instruction,
-                             IARG_INST_PTR, IARG_MEMORYREAD_EA, IARG_MEMORYREAD_SIZE,
-                             IARG_CONST_CONTEXT, IARG_THREAD_ID, IARG_END);
+    INS_InsertIfPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)tainting::input_reading_predicate,
+                               IARG_MEMORYREAD_EA, IARG_MEMORYREAD_SIZE, IARG_END);
+    INS_InsertThenPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)capturing::mem_read_instruction,
+                                 IARG_INST_PTR, IARG_MEMORYREAD_EA, IARG_MEMORYREAD_SIZE,
+                                 IARG_CONST_CONTEXT, IARG_THREAD_ID, IARG_END);
 
     if (INS_HasMemoryRead2(ins))
     {
-      INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)capturing::mem_read_instruction,
-                               IARG_INST_PTR, IARG_MEMORYREAD2_EA, IARG_MEMORYREAD_SIZE,
-                               IARG_CONST_CONTEXT, IARG_THREAD_ID, IARG_END);
+      INS_InsertIfPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)tainting::input_reading_predicate,
+                                 IARG_MEMORYREAD2_EA, IARG_MEMORYREAD_SIZE, IARG_END);
+      INS_InsertThenPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)capturing::mem_read_instruction,
+                                   IARG_INST_PTR, IARG_MEMORYREAD2_EA, IARG_MEMORYREAD_SIZE,
+                                   IARG_CONST_CONTEXT, IARG_THREAD_ID, IARG_END);
     }
   }
   return;
@@ -62,23 +72,45 @@ static auto exec_tainting_phase (INS& ins, ptr_instruction_t examined_ins) -> vo
   }
   else
   {
-    // general logging
-    INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)tainting::generic_instruction,
-                             IARG_INST_PTR, IARG_CONST_CONTEXT, IARG_THREAD_ID, IARG_END);
+    // general logging (the context is used only to log register values)
+    if (event_log_is_enabled())
+    {
+      INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)tainting::generic_instruction,
+                               IARG_INST_PTR, IARG_CONST_CONTEXT, IARG_THREAD_ID, IARG_END);
+    }
+    else
+    {
+      INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)tainting::generic_instruction,
+                               IARG_INST_PTR, IARG_PTR, static_cast<VOID*>(0),
+                               IARG_THREAD_ID, IARG_END);
+    }
 
     if (examined_ins->is_mem_read)
     {
+      // checkpoint saving, the context is passed only when the input is read
+      INS_InsertIfPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)tainting::input_reading_predicate,
+                                 IARG_MEMORYREAD_EA, IARG_MEMORYREAD_SIZE, IARG_END);
+      INS_InsertThenPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)tainting::input_read_instruction,
+                                   IARG_INST_PTR, IARG_MEMORYREAD_EA, IARG_MEMORYREAD_SIZE,
+                                   IARG_CONST_CONTEXT, IARG_THREAD_ID, IARG_END);
+
       // memory read logging
       INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)tainting::mem_read_instruction,
                                IARG_INST_PTR, IARG_MEMORYREAD_EA, IARG_MEMORYREAD_SIZE,
-                               IARG_CONST_CONTEXT, IARG_THREAD_ID, IARG_END);
+                               IARG_THREAD_ID, IARG_END);
 
       if (examined_ins->has_mem_read2)
       {
         // memory read2 (e.g. rep cmpsb instruction)
+        INS_InsertIfPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)tainting::input_reading_predicate,
+                                   IARG_MEMORYREAD2_EA, IARG_MEMORYREAD_SIZE, IARG_END);
+        INS_InsertThenPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)tainting::input_read_instruction,
+                                     IARG_INST_PTR, IARG_MEMORYREAD2_EA, IARG_MEMORYREAD_SIZE,
+                                     IARG_CONST_CONTEXT, IARG_THREAD_ID, IARG_END);
+
         INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)tainting::mem_read_instruction,
                                  IARG_INST_PTR, IARG_MEMORYREAD2_EA, IARG_MEMORYREAD_SIZE,
-                                 IARG_CONST_CONTEXT, IARG_THREAD_ID, IARG_END);
+                                 IARG_THREAD_ID, IARG_END);
       }
     }
 
@@ -87,24 +119,32 @@ static auto exec_tainting_phase (INS& ins, ptr_instruction_t examined_ins) -> vo
       // memory written logging
       INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)tainting::mem_write_instruction,
                                IARG_INST_PTR, IARG_MEMORYWRITE_EA, IARG_MEMORYWRITE_SIZE,
-                               IARG_THREAD_ID, IARG_END);
+                               IARG_REG_VALUE, REG_STACK_PTR, IARG_THREAD_ID, IARG_END);
     }
   }
 
-  /* taint propagating */
-  INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)tainting::graphical_propagation,
+  /* taint propagating, the tainting graph is built only if it is requested */
+  INS_InsertPredicatedCall(ins, IPOINT_BEFORE,
+                           tainting_graph_knob.Value() ? (AFUNPTR)tainting::graphical_propagation
+                                                       : (AFUNPTR)tainting::shadow_propagation,
                            IARG_INST_PTR, IARG_THREAD_ID, IARG_END);
   return;
 }
 
 
 /**
- * @brief instrument codes executed in rollbacking phase
+ * @brief instrument codes executed in rollbacking phase, the generic callback is inserted only if
+ * the execution order is not counted already by the basic block containing the instruction (in
+ * this case, following_ins_num is the number of instructions after it in the block)
  */
-static auto exec_rollbacking_phase (INS& ins, ptr_instruction_t examined_ins) -> void
+static auto exec_rollbacking_phase (INS& ins, ptr_instruction_t examined_ins,
+                                    bool ins_is_counted, UINT32 following_ins_num) -> void
 {
-  INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)rollbacking::generic_instruction,
-                           IARG_INST_PTR, IARG_THREAD_ID, IARG_END);
+  if (!ins_is_counted)
+  {
+    INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)rollbacking::generic_instruction,
+                             IARG_INST_PTR, IARG_THREAD_ID, IARG_END);
+  }
 
   if (examined_ins->is_cond_direct_cf)
   {
@@ -117,7 +157,8 @@ static auto exec_rollbacking_phase (INS& ins, ptr_instruction_t examined_ins) ->
   {
     INS_InsertPredicatedCall(ins, IPOINT_BEFORE, (AFUNPTR)rollbacking::mem_write_instruction,
                              IARG_INST_PTR, IARG_MEMORYWRITE_EA, IARG_MEMORYWRITE_SIZE,
-                             IARG_THREAD_ID, IARG_END);
+                             IARG_UINT32, (ins_is_counted ? following_ins_num : 0),
+                             IARG_REG_VALUE, REG_STACK_PTR, IARG_THREAD_ID, IARG_END);
   }
 #endif
 
@@ -126,64 +167,148 @@ static auto exec_rollbacking_phase (INS& ins, ptr_instruction_t examined_ins) ->
 
 
 /**
- * @brief instruction instrumentation: all analysis functions are inserted using
- * INS_InsertPredicatedCall to make sure that the instruction is examined iff it is executed.
+ * @brief examining statically instructions: get the instruction object at the address of the
+ * instrumented instruction, create it if it has not been examined yet.
  */
-auto instruction_executing (INS ins, VOID *data) -> VOID
+static auto examined_instruction (INS& ins) -> ptr_instruction_t
 {
-  // examining statically instructions
   auto ins_addr = INS_Address(ins);
 
   // verify if the instruction has been examined
   if (ins_at_addr.find(ins_addr) == ins_at_addr.end())
   {
-    // not yet, then create a new instruction object
-    ins_at_addr[ins_addr] = std::make_shared<instruction>(ins);
+    // not yet, then take its cached descriptor or create a new instruction object
+    ins_at_addr[ins_addr] = cached_instruction(ins_addr);
+    if (!ins_at_addr[ins_addr])
+    {
+      ins_at_addr[ins_addr] = std::make_shared<instruction>(ins);
+      cache_instruction(ins_at_addr[ins_addr]);
+    }
     if (ins_at_addr[ins_addr]->is_cond_direct_cf)
     {
       ins_at_addr[ins_addr] = std::make_shared<cond_direct_instruction>(*ins_at_addr[ins_addr]);
     }
 
 #if !defined(DISABLE_FSA)
-    explored_fsa->add_vertex(ins_addr);
+    post_fsa_vertex(ins_addr);
 #endif
   }
 
-  if (current_running_phase != capturing_phase)
+  return ins_at_addr[ins_addr];
+}
+
+
+/**
+ * @brief verify if the execution order can be counted once for the whole basic block: that is the
+ * case if every instruction of the block is executed exactly once whenever the block is entered
+ * (i.e. no predicated instruction, in particular no rep-prefixed one).
+ */
+static auto bbl_is_countable (BBL& bbl) -> bool
+{
+  for (auto ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins))
   {
-    // examining statically instructions
-    auto ins_addr = INS_Address(ins);
+    if (INS_IsPredicated(ins)) return false;
+  }
+  return true;
+}
 
-    // verify if the instruction has been examined
-    if (ins_at_addr.find(ins_addr) == ins_at_addr.end())
+
+/**
+ * @brief instrument traces executed in rollbacking phase: the execution order is counted by a
+ * single callback at the entry of each basic block; the per-instruction generic callback is used
+ * only in blocks which are not countable.
+ */
+static auto exec_rollbacking_phase (TRACE& trace) -> void
+{
+  for (auto bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
+  {
+    auto bbl_is_counted = bbl_is_countable(bbl);
+    if (bbl_is_counted)
     {
-      // not yet, then create a new instruction object
-      ins_at_addr[ins_addr] = std::make_shared<instruction>(ins);
-      if (ins_at_addr[ins_addr]->is_cond_direct_cf)
+      // precompute the rolling hash factors of the block: h -> h * hash_mult + hash_add
+      auto hash_mult = path_hash_t(1); auto hash_add = path_hash_t(0);
+      for (auto ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins))
       {
-        ins_at_addr[ins_addr] = std::make_shared<cond_direct_instruction>(*ins_at_addr[ins_addr]);
+        hash_mult = extend_path_hash(hash_mult, 0);
+        hash_add = extend_path_hash(hash_add, INS_Address(ins));
       }
 
-#if !defined(DISABLE_FSA)
-      explored_fsa->add_vertex(ins_addr);
-#endif
+      BBL_InsertCall(bbl, IPOINT_BEFORE, (AFUNPTR)rollbacking::basic_block,
+                     IARG_ADDRINT, BBL_Address(bbl), IARG_UINT32, BBL_NumIns(bbl),
+                     IARG_ADDRINT, hash_mult, IARG_ADDRINT, hash_add,
+                     IARG_THREAD_ID, IARG_END);
     }
 
-    switch (current_running_phase)
+    auto following_ins_num = BBL_NumIns(bbl);
+    for (auto ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins))
     {
-    case tainting_phase:
-      exec_tainting_phase(ins, ins_at_addr[ins_addr]); break;
+      exec_rollbacking_phase(ins, examined_instruction(ins), bbl_is_counted, --following_ins_num);
+    }
+  }
+  return;
+}
 
-    case rollbacking_phase:
-      exec_rollbacking_phase(ins, ins_at_addr[ins_addr]); break;
 
-    default:
-      break;
-    }
+/**
+ * @brief the value of the current running phase, it is returned into the phase register
+ */
+static auto current_phase_value () -> ADDRINT
+{
+  return current_running_phase;
+}
+
+
+/**
+ * @brief trace instrumentation: all analysis functions are inserted using
+ * INS_InsertPredicatedCall to make sure that the instruction is examined iff it is executed.
+ *
+ * Each running phase has its own version of the trace, so switching phases does not need to
+ * remove the instrumentation: at the entry of the trace, the current phase is loaded into the
+ * phase register and the execution moves to the version of this phase if it is not the version
+ * of the trace.
+ */
+auto trace_executing (TRACE trace, VOID *data) -> VOID
+{
+  auto trace_phase = static_cast<running_phase>(TRACE_Version(trace));
+
+  auto head_ins = BBL_InsHead(TRACE_BblHead(trace));
+  INS_InsertCall(head_ins, IPOINT_BEFORE, (AFUNPTR)current_phase_value,
+                 IARG_RETURN_REGS, phase_reg, IARG_END);
+  for (auto phase : { capturing_phase, tainting_phase, rollbacking_phase })
+  {
+    if (phase != trace_phase) INS_InsertVersionCase(head_ins, phase_reg, phase, phase, IARG_END);
   }
-  else
+
+  switch (trace_phase)
   {
-    if (interested_msg_is_received) exec_capturing_phase(ins);
+  case capturing_phase:
+    if (interested_msg_is_received)
+    {
+      for (auto bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
+      {
+        for (auto ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins))
+        {
+          examined_instruction(ins); exec_capturing_phase(ins);
+        }
+      }
+    }
+    break;
+
+  case tainting_phase:
+    for (auto bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
+    {
+      for (auto ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins))
+      {
+        exec_tainting_phase(ins, examined_instruction(ins));
+      }
+    }
+    break;
+
+  case rollbacking_phase:
+    exec_rollbacking_phase(trace); break;
+
+  default:
+    break;
   }
 
   return;
@@ -298,6 +423,16 @@ auto process_creating (CHILD_PROCESS created_process, VOID* data) -> BOOL
 }
 
 
+/**
+ * @brief claim the phase register, must be called before the program starts
+ */
+auto claim_phase_register () -> void
+{
+  phase_reg = PIN_ClaimToolRegister();
+  return;
+}
+
+
 /**
  * @brief initialize_instrumenter
  */
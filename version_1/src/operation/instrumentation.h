@@ -6,7 +6,7 @@
 
 namespace instrumentation
 {
-extern auto instruction_executing   (INS ins, VOID* data)                       -> VOID;
+extern auto trace_executing         (TRACE trace, VOID* data)                   -> VOID;
 
 extern auto routine_calling         (RTN rtn, VOID* data)                       -> VOID;
 
@@ -14,6 +14,8 @@ extern auto image_loading           (IMG loaded_img, VOID *data)
 
 extern auto process_creating        (CHILD_PROCESS created_process, VOID* data) -> BOOL;
 
+extern auto claim_phase_register    ()                                          -> void;
+
 extern auto initialize              ()                                          -> void;
 } // end of instrumentation namespace
 
@@ -1,33 +1,63 @@
 #include "tainting_phase.h"
+#include "exploring_scheduler.h"
+#include "exploring_workers.h"
 #include "../common.h"
 #include "../util/stuffs.h"
 
 #include <cstdlib>
 #include <limits>
 #include <algorithm>
+#include <iterator>
 #include <functional>
+#include <vector>
 
 /*================================================================================================*/
 
 typedef enum
 {
   randomized = 0,
-  sequential = 1
+  sequential = 1,
+  bisecting  = 2
 }                               input_generation_mode;
 
+typedef enum
+{
+  original_decision = 0,
+  flipped_decision  = 1,
+  diverted_decision = 2         // some other CFI changes the control flow before the active one
+}                               cfi_decision;
+
 static ptr_cond_direct_ins_t    active_cfi;
 static ptr_checkpoint_t         active_checkpoint;
 static ptr_checkpoint_t         first_checkpoint;
 static UINT32                   max_rollback_num;
 static UINT32                   used_rollback_num;
+static UINT32                   flipped_rollback_num;
+static UINT32                   saved_rollback_num;
+static bool                     rollback_is_extended;
 static UINT32                   tainted_trace_length;
 static addrint_set_t            active_modified_addrs;
 static addrint_value_map_t      active_modified_addrs_values;
+static std::vector<path_hash_t> path_hash_at_order;
+static path_hash_t              single_ins_hash_mult;
 //static addrint_value_map_t      input_on_active_modified_addrs;
 //static ptr_uint8_t              fresh_input;
 static ptr_uint8_t              tainting_input;
 static input_generation_mode    gen_mode;
 
+// bisection of the domain of a 1 or 2 bytes CFI: probed values with their decisions, the grid of
+// values probed at first, and the value of the pending probe
+static std::map<UINT32, cfi_decision> decision_at_value;
+static std::vector<UINT32>      grid_probe_values;
+static UINT32                   probe_value;
+static bool                     probe_is_pending;
+static cfi_decision             probe_decision;
+static UINT32                   spot_check_num;
+static bool                     bisection_is_done;
+
+static const UINT32             grid_interval_num = 16;
+static const UINT32             max_spot_check_num = 8;
+
 //std::function<addrint_value_map_t(const addrint_value_map_t&)>  generate_testing_input;
 
 typedef std::function<void(addrint_value_map_t&)> input_updater_t;
@@ -128,6 +158,252 @@ static auto random_update (addrint_value_map_t& updated_map) -> void
 }
 
 
+/**
+ * @brief the value of active modified addresses as an integer, the first address is the lowest byte
+ * (as in sequential_update)
+ */
+static auto value_of_modified_addrs (const addrint_value_map_t& addrs_values) -> UINT32
+{
+  auto value = UINT32(0), shift = UINT32(0);
+  std::for_each(addrs_values.begin(), addrs_values.end(),
+                [&](addrint_value_map_t::const_reference addr_val)
+  {
+    value |= static_cast<UINT32>(std::get<1>(addr_val)) << shift; shift += 8;
+  });
+  return value;
+}
+
+
+static auto set_value_of_modified_addrs (addrint_value_map_t& addrs_values, UINT32 value) -> void
+{
+  std::for_each(addrs_values.begin(), addrs_values.end(),
+                [&value](addrint_value_map_t::reference addr_val)
+  {
+    std::get<1>(addr_val) = value & 0xFF; value >>= 8;
+  });
+  return;
+}
+
+
+/**
+ * @brief the first value from a given one (cyclically) which has not been probed by the bisection,
+ * since the decision of a probed value has been already recorded as an input projection; some value
+ * must be unprobed
+ */
+static auto next_unprobed_value (UINT32 value, UINT32 domain_size) -> UINT32
+{
+  while (decision_at_value.find(value) != decision_at_value.end()) value = (value + 1) % domain_size;
+  return value;
+}
+
+
+/**
+ * @brief sweep_update: the next unprobed value
+ */
+static auto sweep_update (addrint_value_map_t& updated_map) -> void
+{
+  auto domain_size = UINT32(1) << (8 * updated_map.size());
+  set_value_of_modified_addrs(updated_map, next_unprobed_value(
+                                (value_of_modified_addrs(updated_map) + 1) % domain_size,
+                                domain_size));
+  return;
+}
+
+
+/**
+ * @brief bisection_update: the value of the next probe is already planned
+ */
+static auto bisection_update (addrint_value_map_t& updated_map) -> void
+{
+  set_value_of_modified_addrs(updated_map, probe_value); probe_is_pending = true;
+  return;
+}
+
+
+/**
+ * @brief initialize the bisection of the domain, the value of the original input is known to give
+ * the original decision
+ */
+static auto initialize_bisection () -> void
+{
+  auto domain_size = max_rollback_num + 1;
+
+  decision_at_value.clear();
+  decision_at_value[value_of_modified_addrs(active_modified_addrs_values)] = original_decision;
+
+  grid_probe_values.clear();
+  for (UINT32 grid_idx = 0; grid_idx <= grid_interval_num; ++grid_idx)
+  {
+    grid_probe_values.push_back(grid_idx * (domain_size - 1) / grid_interval_num);
+  }
+  std::reverse(grid_probe_values.begin(), grid_probe_values.end());
+
+  probe_is_pending = false; spot_check_num = 0; bisection_is_done = false;
+  return;
+}
+
+
+/**
+ * @brief the decision inferred for a value: the one of the greatest probed value not above it (the
+ * grid contains 0 so such a probed value always exists)
+ */
+static auto inferred_decision (UINT32 value) -> cfi_decision
+{
+  return std::get<1>(*std::prev(decision_at_value.upper_bound(value)));
+}
+
+
+/**
+ * @brief the middle of the first pair of consecutive probed values having different decisions and
+ * some unprobed value between them; return false if there is no such pair
+ */
+static auto next_bisection_value (UINT32& middle_value) -> bool
+{
+  auto value_iter = decision_at_value.begin();
+  for (auto next_iter = std::next(value_iter); next_iter != decision_at_value.end();
+       value_iter = next_iter, ++next_iter)
+  {
+    if ((std::get<1>(*value_iter) != std::get<1>(*next_iter)) &&
+        (std::get<0>(*next_iter) - std::get<0>(*value_iter) > 1))
+    {
+      middle_value = (std::get<0>(*value_iter) + std::get<0>(*next_iter)) / 2;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+/**
+ * @brief the bisection is inconsistent (or finds no boundary), then sweep the rest of the domain:
+ * the probed values are skipped since their projections have been already recorded
+ */
+static auto fall_back_to_sequential_sweep () -> void
+{
+#if !defined(NDEBUG)
+  tfm::format(log_file, "the CFI at %d falls back to the sequential sweep after %d rollbacks\n",
+              active_cfi->exec_order, used_rollback_num);
+#endif
+  auto domain_size = max_rollback_num + 1;
+  max_rollback_num = used_rollback_num + domain_size - static_cast<UINT32>(decision_at_value.size());
+  gen_mode = sequential; update_input = sweep_update;
+
+  // the sweep starts from the original value of the input
+  std::for_each(active_modified_addrs_values.begin(), active_modified_addrs_values.end(),
+                [&](addrint_value_map_t::reference addr_val)
+  {
+    std::get<1>(addr_val) = fresh_input.get()[std::get<0>(addr_val) - received_msg_addr];
+  });
+  return;
+}
+
+
+/**
+ * @brief the bisection is done, the decisions of unprobed values are pushed as input projections
+ * as if the whole domain was swept; these decisions are inferred, a narrow interval missed by both
+ * the grid and the spot checks gives wrong projections
+ */
+static auto complete_bisection () -> void
+{
+  auto domain_size = max_rollback_num + 1;
+  auto projection = active_modified_addrs_values;
+  for (UINT32 value = 0; value < domain_size; ++value)
+  {
+    if (decision_at_value.find(value) == decision_at_value.end())
+    {
+      set_value_of_modified_addrs(projection, value);
+      switch (inferred_decision(value))
+      {
+      case original_decision:
+        active_cfi->first_input_projections.push_back(projection); break;
+      case flipped_decision:
+        active_cfi->second_input_projections.push_back(projection); break;
+      default:
+        break;
+      }
+    }
+  }
+
+#if !defined(NDEBUG)
+  tfm::format(log_file, "the CFI at %d is bisected with %d rollbacks\n", active_cfi->exec_order,
+              used_rollback_num);
+#endif
+  // the next rollback restores the original input
+  max_rollback_num = used_rollback_num; bisection_is_done = true;
+  return;
+}
+
+
+/**
+ * @brief plan a spot check at a random unprobed value, or complete the bisection if there are
+ * enough spot checks (or no unprobed value)
+ */
+static auto plan_spot_check () -> void
+{
+  auto domain_size = max_rollback_num + 1;
+  if ((spot_check_num < max_spot_check_num) && (decision_at_value.size() < domain_size))
+  {
+    spot_check_num++;
+    probe_value = next_unprobed_value((*ptr_rand_engine)() % domain_size, domain_size);
+  }
+  else complete_bisection();
+  return;
+}
+
+
+/**
+ * @brief record the decision of the pending probe and plan the next one: probe the grid, then
+ * bisect between consecutive probed values of different decisions, then spot check some random
+ * values against the inferred partition.
+ */
+static auto plan_next_probe () -> void
+{
+  if (bisection_is_done) return;
+
+  if (probe_is_pending)
+  {
+    probe_is_pending = false;
+    auto probe_is_consistent = (spot_check_num == 0) ||
+        (probe_decision == inferred_decision(probe_value));
+    decision_at_value[probe_value] = probe_decision;
+    if (!probe_is_consistent)
+    {
+      // the inferred partition is inconsistent
+      fall_back_to_sequential_sweep(); return;
+    }
+  }
+
+  // a probed value is not probed again, its projection would be recorded twice
+  while (!grid_probe_values.empty() &&
+         (decision_at_value.find(grid_probe_values.back()) != decision_at_value.end()))
+  {
+    grid_probe_values.pop_back();
+  }
+
+  if (!grid_probe_values.empty())
+  {
+    probe_value = grid_probe_values.back(); grid_probe_values.pop_back();
+  }
+  else if (spot_check_num == 0)
+  {
+    if (!next_bisection_value(probe_value))
+    {
+      // the partition is found, but a partition without boundary is not a proof of singularity
+      auto has_boundary = std::any_of(std::next(decision_at_value.begin()), decision_at_value.end(),
+                                      [](decltype(decision_at_value)::const_reference value_decision)
+      {
+        return std::get<1>(value_decision) != std::get<1>(*decision_at_value.begin());
+      });
+      if (!has_boundary) fall_back_to_sequential_sweep();
+      else plan_spot_check();
+    }
+  }
+  else plan_spot_check();
+
+  return;
+}
+
+
 /**
  * @brief initialize_values_at_active_modified_addrs
  */
@@ -145,16 +421,18 @@ static auto initialize_values_at_active_modified_addrs () -> void
   {
   case 1:
     max_rollback_num = std::numeric_limits<UINT8>::max();
-    gen_mode = sequential;
+    gen_mode = bisection_knob.Value() ? bisecting : sequential;
 //    generate_testing_input = sequential_generator<UINT8>;
-    update_input = sequential_update;
+    update_input = bisection_knob.Value() ? input_updater_t(bisection_update)
+                                          : input_updater_t(sequential_update);
     break;
 
   case 2:
     max_rollback_num = std::numeric_limits<UINT16>::max();
-    gen_mode = sequential;
+    gen_mode = bisection_knob.Value() ? bisecting : sequential;
 //    generate_testing_input = sequential_generator<UINT16>;
-    update_input = sequential_update;
+    update_input = bisection_knob.Value() ? input_updater_t(bisection_update)
+                                          : input_updater_t(sequential_update);
     break;
 
 //  case 4:
@@ -173,13 +451,66 @@ static auto initialize_values_at_active_modified_addrs () -> void
     break;
   }
 
-  used_rollback_num = 0;
+  used_rollback_num = 0; flipped_rollback_num = 0;
+  rollback_is_extended = false;
+  if (gen_mode == bisecting) initialize_bisection();
+  return;
+}
+
+
+/**
+ * @brief adjust the rollback budget of the active checkpoint: give up early if the probability of
+ * flipping the active CFI is negligible, and give the saved rollbacks to some promising CFI later.
+ */
+static auto adjust_rollback_budget () -> void
+{
+  if (used_rollback_num < max_rollback_num)
+  {
+    // the bisection decides the next probe, it may also end (or extend) the budget
+    if (gen_mode == bisecting) plan_next_probe();
+
+    // no flipping after n random rollbacks, then 3/n is an upper bound (rule of three) of the
+    // flipping probability, verify if this bound is already negligible (the bound does not hold for
+    // the sequential or bisecting generations since their values are not sampled randomly)
+    if ((used_rollback_num < max_rollback_num) && (gen_mode == randomized) &&
+        (flipped_rollback_num == 0) && (used_rollback_num > 0) &&
+        (3.0 / used_rollback_num < giveup_probability_knob.Value()))
+    {
+      // it is, then give up the active checkpoint and save its remaining rollbacks
+      saved_rollback_num += max_rollback_num - used_rollback_num;
+      max_rollback_num = used_rollback_num;
+#if !defined(NDEBUG)
+      tfm::format(log_file, "the CFI at %d gives up its checkpoint at %d after %d rollbacks, saved rollbacks %d\n",
+                  active_cfi->exec_order, active_checkpoint->exec_order, used_rollback_num,
+                  saved_rollback_num);
+#endif
+    }
+  }
+  else
+  {
+    // the budget is used up, then verify if the active CFI is still promising (i.e. both decisions
+    // have been observed) so that the randomized testing can continue with the saved rollbacks
+    if ((used_rollback_num == max_rollback_num) && (gen_mode == randomized) &&
+        !rollback_is_extended && (saved_rollback_num > 0) &&
+        (flipped_rollback_num > 0) && (flipped_rollback_num < used_rollback_num))
+    {
+      auto extended_rollback_num = std::min(saved_rollback_num, max_local_rollback_knob.Value());
+      max_rollback_num += extended_rollback_num; saved_rollback_num -= extended_rollback_num;
+      rollback_is_extended = true;
+#if !defined(NDEBUG)
+      tfm::format(log_file, "the CFI at %d extends its checkpoint at %d by %d rollbacks\n",
+                  active_cfi->exec_order, active_checkpoint->exec_order, extended_rollback_num);
+#endif
+    }
+  }
   return;
 }
 
 
 static auto rollback () -> void
 {
+  adjust_rollback_budget();
+
   // verify if the number of used rollbacks has reached its bound
   if (used_rollback_num < max_rollback_num)
   {
@@ -258,10 +589,10 @@ static auto next_checkpoint_and_addrs (ptr_checkpoint_t input_checkpoint,
  * @brief calculate an input for the new tainting phase
  */
 static auto calculate_tainting_fresh_input(
-    const ptr_uint8_t selected_input, const addrint_value_map_t& modified_addrs_with_values) -> void
+    const ptr_input_t selected_input, const addrint_value_map_t& modified_addrs_with_values) -> void
 {
   // make a copy in fresh input of the selected input
-  std::copy(selected_input.get(), selected_input.get() + received_msg_size, fresh_input.get());
+  selected_input->copy_to(fresh_input.get());
 
   std::for_each(std::begin(modified_addrs_with_values), std::end(modified_addrs_with_values),
                 [&](addrint_value_map_t::const_reference addr_value)
@@ -278,10 +609,11 @@ static auto calculate_tainting_fresh_input(
  */
 static auto prepare_new_tainting_phase () -> void
 {
-  show_exploring_progress();
+  // a worker leaves the progress and the rollback budget to its coordinator
+  if (!is_exploring_worker()) show_exploring_progress();
 
   // verify if the number of used rollback time has exceeded its bounded value
-  if (total_rollback_times >= max_total_rollback_times)
+  if (!is_exploring_worker() && (total_rollback_times >= max_total_rollback_times))
   {
     // exceeded, then stop exploring
 #if !defined(NDEBUG)
@@ -291,27 +623,22 @@ static auto prepare_new_tainting_phase () -> void
   }
   else
   {
-    // not exceeded yet, then verify if there exists a resolved but unexplored CFI
-    if (std::any_of(std::begin(detected_input_dep_cfis), std::end(detected_input_dep_cfis),
-                    [&](decltype(detected_input_dep_cfis)::reference cfi_elem) -> bool
-    {
-      if (cfi_elem->is_resolved && !cfi_elem->is_explored)
-      {
-        exploring_cfi = cfi_elem;
-        // a unexplored CFI exists, then set it as explored
-        exploring_cfi->is_explored = true;
-        // calculate a new input for the next tainting phase
-        calculate_tainting_fresh_input(exploring_cfi->fresh_input,
-                                       exploring_cfi->second_input_projections[0]);
-
-        // initialize new tainting phase
-        current_running_phase = tainting_phase; tainting::initialize();
-        return true;
-      }
-      else return false;
-    }))
+    // not exceeded yet, then verify if the scheduler (or the coordinator of workers) has a
+    // resolved but unexplored CFI
+    auto scheduled_cfi = next_exploring_cfi();
+    if (scheduled_cfi)
     {
-      // exists, then explore this CFI
+      exploring_cfi = scheduled_cfi;
+      // a unexplored CFI exists, then set it as explored
+      exploring_cfi->is_explored = true;
+      // calculate a new input for the next tainting phase
+      calculate_tainting_fresh_input(exploring_cfi->fresh_input,
+                                     exploring_cfi->second_input_projections[0]);
+
+      // initialize new tainting phase
+      current_running_phase = tainting_phase; tainting::initialize();
+
+      // then explore this CFI
 #if !defined(NDEBUG)
       tfm::format(log_file, "%s\nexplore the CFI %s at %d, start tainting\n",
                   "=================================================================================",
@@ -319,8 +646,8 @@ static auto prepare_new_tainting_phase () -> void
 //      log_file.flush();
 #endif
 
-      // rollback to the first checkpoint with the new input
-      PIN_RemoveInstrumentation();
+      // rollback to the first checkpoint with the new input (the instrumented traces of the
+      // tainting phase are selected at the trace entries, so the code cache is kept)
       rollback_with_new_input(first_checkpoint, current_exec_order, received_msg_addr,
                               received_msg_size, fresh_input.get());
     }
@@ -338,6 +665,29 @@ static auto prepare_new_tainting_phase () -> void
 }
 
 
+/**
+ * @brief verify if the instructions executed from the current execution order are in the original
+ * trace, by comparing the rolling hash of the original trace at the end of these instructions with
+ * the one extended by them (the hash of n instructions is given by hash_mult and hash_add). The
+ * check is clamped to the recorded trace: instructions past its end are considered as followed,
+ * and only the first instruction of a block is checked if the block runs past the end (it is the
+ * only one which can diverge).
+ */
+static auto original_trace_is_followed (ADDRINT ins_addr, UINT32 ins_num,
+                                        path_hash_t hash_mult, path_hash_t hash_add) -> bool
+{
+  auto last_exec_order = current_exec_order + ins_num - 1;
+  if (last_exec_order < path_hash_at_order.size())
+  {
+    return (path_hash_at_order[current_exec_order - 1] * hash_mult + hash_add ==
+            path_hash_at_order[last_exec_order]);
+  }
+  return ((current_exec_order >= path_hash_at_order.size()) ||
+          (extend_path_hash(path_hash_at_order[current_exec_order - 1], ins_addr) ==
+           path_hash_at_order[current_exec_order]));
+}
+
+
 /**
  * @brief This function aims to give a generic approach for solving control-flow instructions. The
  * main idea is to verify if the re-executed trace (i.e. rollback with a modified input) is the
@@ -345,84 +695,113 @@ static auto prepare_new_tainting_phase () -> void
  * trace then that must be resulted from a control-flow instruction which has changed the control
  * flow, so the new instruction will not be executed and we take a rollback.
  *
+ * The executed instructions are a single instruction or a whole basic block, in the latter case
+ * only its first instruction can be out of the original trace, so the divergence point is always
+ * the current execution order.
+ *
  * Its semantics is quite sophisticated because there are several conditions to check.
  *
- * @param ins_addr: the address of the current examined instruction.
+ * @param ins_addr: the address of the first executed instruction.
+ * @param ins_num: the number of executed instructions.
+ * @param hash_mult, hash_add: the rolling hash factors of the executed instructions.
  * @return no return value.
  */
-auto generic_instruction (ADDRINT ins_addr, THREADID thread_id) -> VOID
+static auto executed_instructions (ADDRINT ins_addr, UINT32 ins_num,
+                                   path_hash_t hash_mult, path_hash_t hash_add) -> void
 {
-  if (thread_id == traced_thread_id)
+  // the rollbacking phase stops when the execution order exceeds the last CFI
+  auto stop_rollbacking = []() -> void
   {
-    // verify if the execution order of the instruction exceeds the last CFI
-    if (current_exec_order >= tainted_trace_length)
+    // first, save the current execution path and insert it into the DFA: all CFIs of the path
+    // have been rollbacked (and the ones before the exploring CFI in former phases), so its
+    // condition will not change anymore
+    current_exec_path = std::make_shared<execution_path>(ins_at_order, current_path_code);
+    if (is_exploring_worker()) send_explored_path(current_exec_path);
+    else
     {
-      // exceeds, namely the rollbacking phase should stop:
-
-      // first, save the current execution path
-      current_exec_path = std::make_shared<execution_path>(ins_at_order, current_path_code);
       explored_exec_paths.push_back(current_exec_path);
-
-      // second, prepare tainting a new path
-      prepare_new_tainting_phase();
+      current_exec_path->calculate_condition(); abstracted_dfa->add_exec_path(current_exec_path);
     }
-    else
-    {
-      current_exec_order++;
 
-      // verify if the executed instruction is in the original trace
-      if (ins_at_order[current_exec_order]->address != ins_addr)
+    // second, prepare tainting a new path
+    prepare_new_tainting_phase();
+  };
+
+  // verify if the execution order of the instruction exceeds the last CFI
+  if (current_exec_order >= tainted_trace_length)
+  {
+    // exceeds, namely the rollbacking phase should stop
+    stop_rollbacking();
+  }
+  else
+  {
+    current_exec_order++;
+
+    // verify if the executed instructions are in the original trace
+    if (!original_trace_is_followed(ins_addr, ins_num, hash_mult, hash_add))
+    {
+      // is not in, then verify if the current control-flow instruction (abbr. CFI) is activated
+      if (active_cfi)
       {
-        // is not in, then verify if the current control-flow instruction (abbr. CFI) is activated
-        if (active_cfi)
+        // activated, that means the rollback from some checkpoint of this CFI will change the
+        // control-flow, then verify if the CFI is the just previous executed instruction
+        if (active_cfi->exec_order + 1 == current_exec_order)
         {
-          // activated, that means the rollback from some checkpoint of this CFI will change the
-          // control-flow, then verify if the CFI is the just previous executed instruction
-          if (active_cfi->exec_order + 1 == current_exec_order)
-          {
 #if !defined(NDEBUG)
-            if (!active_cfi->is_resolved)
-            {
-              tfm::format(log_file, "the CFI %s at %d is resolved\n", active_cfi->disassembled_name,
-                          active_cfi->exec_order);
-            }
-#endif
-            // it is, then it will be marked as resolved
-            active_cfi->is_resolved = true;
-
-            // push an input projection into the corresponding input list of the active CFI
-            active_cfi->second_input_projections.push_back(active_modified_addrs_values);
-          }
-          else
+          if (!active_cfi->is_resolved)
           {
-            // it is not, that means some other CFI (between the current CFI and the checkpoint) will
-            // change the control flow
+            tfm::format(log_file, "the CFI %s at %d is resolved\n", active_cfi->disassembled_name,
+                        active_cfi->exec_order);
           }
-          // in both cases, we need rollback
-          rollback();
+#endif
+          // it is, then it will be marked as resolved and scheduled to be explored (a worker sends
+          // it to the coordinator which schedules it)
+          if (!active_cfi->is_resolved && !is_exploring_worker()) schedule_cfi(active_cfi);
+          active_cfi->is_resolved = true; flipped_rollback_num++;
+
+          // push an input projection into the corresponding input list of the active CFI
+          active_cfi->second_input_projections.push_back(active_modified_addrs_values);
+          probe_decision = flipped_decision;
         }
-#if !defined(NDEBUG)
         else
         {
-          // not activated, then some errors have occurred
-          tfm::format(log_file, "fatal: there is no active CFI but the original trace changes (%s %d)\n",
-                      addrint_to_hexstring(ins_addr), current_exec_order);
-          PIN_ExitApplication(1);
+          // it is not, that means some other CFI (between the current CFI and the checkpoint) will
+          // change the control flow
+          probe_decision = diverted_decision;
         }
-#endif
+        // in both cases, we need rollback
+        rollback();
       }
+#if !defined(NDEBUG)
       else
       {
-        // the executed instruction is in the original trace, then verify if there exists active CFI
-        // and the executed instruction has exceeded this CFI
-        if (active_cfi && (current_exec_order > active_cfi->exec_order))
-        {
-          // yes, then push an input projection into the corresponding input list of the active CFI
-          active_cfi->first_input_projections.push_back(active_modified_addrs_values);
-          // and rollback
-          rollback();
-        }
+        // not activated, then some errors have occurred
+        tfm::format(log_file, "fatal: there is no active CFI but the original trace changes (%s %d)\n",
+                    addrint_to_hexstring(ins_addr), current_exec_order);
+        PIN_ExitApplication(1);
       }
+#endif
+    }
+    else
+    {
+      // the executed instruction is in the original trace, then verify if there exists active CFI
+      // and the executed instruction has exceeded this CFI
+      if (active_cfi && (current_exec_order > active_cfi->exec_order))
+      {
+        // yes, then push an input projection into the corresponding input list of the active CFI
+        active_cfi->first_input_projections.push_back(active_modified_addrs_values);
+        probe_decision = original_decision;
+        // and rollback
+        rollback();
+      }
+
+      // no, then verify if the executed instructions run past the last CFI: the phase stops at the
+      // head of such a block, its instructions within the limit need no examination because none
+      // of them is a CFI (a CFI always ends its block)
+      if (current_exec_order + ins_num - 1 > tainted_trace_length) stop_rollbacking();
+
+      // else continue with the execution order of the last executed instruction
+      current_exec_order += ins_num - 1;
     }
   }
 
@@ -430,6 +809,38 @@ auto generic_instruction (ADDRINT ins_addr, THREADID thread_id) -> VOID
 }
 
 
+/**
+ * @brief generic_instruction
+ */
+auto generic_instruction (ADDRINT ins_addr, THREADID thread_id) -> VOID
+{
+  if (thread_id == traced_thread_id)
+  {
+    executed_instructions(ins_addr, 1, single_ins_hash_mult, ins_addr);
+  }
+  return;
+}
+
+
+/**
+ * @brief Execution order counting for a whole basic block: the block has no internal control flow
+ * and no predicated instruction, so its instructions are examined together by the rolling hash of
+ * their addresses (precomputed in the instrumentation as hash_mult and hash_add).
+ *
+ * @param bbl_addr: the address of the first instruction of the block.
+ * @param bbl_ins_num: the number of instructions of the block.
+ */
+auto basic_block (ADDRINT bbl_addr, UINT32 bbl_ins_num, ADDRINT hash_mult, ADDRINT hash_add,
+                  THREADID thread_id) -> VOID
+{
+  if (thread_id == traced_thread_id)
+  {
+    executed_instructions(bbl_addr, bbl_ins_num, hash_mult, hash_add);
+  }
+  return;
+}
+
+
 /**
  * @brief control_flow_instruction
  */
@@ -488,7 +899,7 @@ auto control_flow_instruction(ADDRINT ins_addr, THREADID thread_id) -> VOID
                               active_cfi->is_singular);
                 }
 #endif
-                active_cfi.reset(); used_rollback_num = 0;
+                active_cfi.reset(); used_rollback_num = 0; flipped_rollback_num = 0;
               }
             }
           }
@@ -526,10 +937,11 @@ auto control_flow_instruction(ADDRINT ins_addr, THREADID thread_id) -> VOID
 
 
 /**
- * @brief tracking instructions that write memory
+ * @brief tracking instructions that write memory, when the execution order is counted by the
+ * basic block then following_ins_num is the number of instructions after this one in the block
  */
-auto mem_write_instruction(ADDRINT ins_addr,
-                           ADDRINT mem_addr, UINT32 mem_length, THREADID thread_id) -> VOID
+auto mem_write_instruction(ADDRINT ins_addr, ADDRINT mem_addr, UINT32 mem_length,
+                           UINT32 following_ins_num, ADDRINT stack_ptr, THREADID thread_id) -> VOID
 {
   if (thread_id == traced_thread_id)
   {
@@ -544,10 +956,11 @@ auto mem_write_instruction(ADDRINT ins_addr,
     {
       // no, namely we are now in normal "forward" execution, so all checkpoint until the current
       // execution order need to track memory write instructions
+      auto ins_exec_order = current_exec_order - following_ins_num;
       std::any_of(std::begin(saved_checkpoints), std::end(saved_checkpoints),
                   [&](decltype(saved_checkpoints)::reference checkpoint_elem) -> bool
       {
-        if (checkpoint_elem->exec_order <= current_exec_order)
+        if (checkpoint_elem->exec_order <= ins_exec_order)
         {
           checkpoint_elem->mem_write_tracking(mem_addr, mem_length); return false;
         }
@@ -555,6 +968,11 @@ auto mem_write_instruction(ADDRINT ins_addr,
       });
     }
   }
+  else
+  {
+    // other threads track memory write operations in their own logs
+    thread_mem_write_tracking(thread_id, mem_addr, mem_length, stack_ptr);
+  }
   return;
 }
 
@@ -567,10 +985,25 @@ auto initialize(UINT32 trace_length_limit) -> void
   // reinitialize some local variables
   active_cfi.reset(); active_checkpoint.reset();
   first_checkpoint = saved_checkpoints[0];
+  // the first checkpoint is the earliest one which can be rollbacked to from now on
+  prune_thread_mem_writes(first_checkpoint->write_sequence);
   active_modified_addrs.clear();
-  tainted_trace_length = trace_length_limit; used_rollback_num = 0;
+  tainted_trace_length = trace_length_limit; used_rollback_num = 0; flipped_rollback_num = 0;
+  // the rollbacks saved by given up checkpoints are lent only to CFIs of the same phase
+  saved_rollback_num = 0; rollback_is_extended = false;
   max_rollback_num = max_local_rollback_knob.Value();
   gen_mode = randomized;
+
+  // summarize the original trace as rolling hashes at each execution order
+  single_ins_hash_mult = extend_path_hash(1, 0);
+  path_hash_at_order.assign(ins_at_order.rbegin()->first + 1, 0);
+  auto path_hash = path_hash_t(0);
+  std::for_each(ins_at_order.begin(), ins_at_order.end(),
+                [&](decltype(ins_at_order)::const_reference order_ins)
+  {
+    path_hash = extend_path_hash(path_hash, std::get<1>(order_ins)->address);
+    path_hash_at_order[std::get<0>(order_ins)] = path_hash;
+  });
   return;
 }
 
@@ -10,8 +10,13 @@ extern auto initialize                (UINT32 trace_length_limit)             ->
 
 extern auto generic_instruction       (ADDRINT ins_addr, THREADID thread_id)  -> VOID;
 
+extern auto basic_block               (ADDRINT bbl_addr, UINT32 bbl_ins_num,
+                                       ADDRINT hash_mult, ADDRINT hash_add,
+                                       THREADID thread_id)                    -> VOID;
+
 extern auto mem_write_instruction     (ADDRINT ins_addr, ADDRINT mem_addr,
-                                       UINT32 mem_length, THREADID thread_id) -> VOID;
+                                       UINT32 mem_length, UINT32 following_ins_num,
+                                       ADDRINT stack_ptr, THREADID thread_id) -> VOID;
 
 extern auto control_flow_instruction  (ADDRINT ins_addr, THREADID thread_id)  -> VOID;
 }
@@ -14,6 +14,7 @@ static std::vector<df_edge_desc>  visited_edges;
 static df_diagram                 dta_graph;
 static df_vertex_desc_set         dta_outer_vertices;
 static UINT32                     rollbacking_trace_length;
+static std::map<ADDRINT, UINT32>  first_checkpoint_idx_at_input_addr;
 
 #if !defined(NDEBUG)
 static ptr_cond_direct_inss_t     newly_detected_input_dep_cfis;
@@ -94,111 +95,58 @@ static auto determine_cfi_input_dependency() -> void
 }
 
 
+/**
+ * @brief index each input address by the earliest checkpoint reading it; checkpoints are saved
+ * along the execution so the earliest one is the first in the saved list.
+ */
+static auto index_checkpoints_by_input_addr () -> void
+{
+  first_checkpoint_idx_at_input_addr.clear();
+  for (UINT32 chkpnt_idx = 0; chkpnt_idx < saved_checkpoints.size(); ++chkpnt_idx)
+  {
+    std::for_each(std::begin(saved_checkpoints[chkpnt_idx]->input_dep_original_values),
+                  std::end(saved_checkpoints[chkpnt_idx]->input_dep_original_values),
+                  [&](addrint_value_map_t::const_reference addr_val)
+    {
+      // an existing index is kept since it is of some earlier checkpoint
+      first_checkpoint_idx_at_input_addr.insert(std::make_pair(std::get<0>(addr_val), chkpnt_idx));
+    });
+  }
+  return;
+}
+
+
 /**
  * @brief for each CFI, determine pairs of <checkpoint, affecting input addresses> so that a
  * rollback from the checkpoint with the modification on the affecting input addresses may change
- * the CFI's decision.
+ * the CFI's decision. Each affecting input address is assigned to the earliest checkpoint (before
+ * the CFI) reading it, so only the checkpoints indexed by the CFI's input addresses are touched.
  */
 static auto set_checkpoints_for_cfi(/*const */ptr_cond_direct_ins_t/*&*/ cfi) -> void
 {
-  auto dep_addrs = cfi->input_dep_addrs;
-  decltype(dep_addrs) input_dep_addrs, new_dep_addrs, intersected_addrs;
-  checkpoint_addrs_pair_t checkpoint_with_input_addrs;
+  std::map<UINT32, addrint_set_t> input_addrs_at_checkpoint_idx;
 
-  std::all_of(std::begin(saved_checkpoints), std::end(saved_checkpoints),
-              [&](decltype(saved_checkpoints)::value_type chkpnt) -> bool
+  std::for_each(std::begin(cfi->input_dep_addrs), std::end(cfi->input_dep_addrs),
+                [&](ADDRINT input_addr)
   {
+    auto idx_iter = first_checkpoint_idx_at_input_addr.find(input_addr);
     // consider only checkpoints before the CFI
-    if (chkpnt->exec_order <= cfi->exec_order)
+    if ((idx_iter != first_checkpoint_idx_at_input_addr.end()) &&
+        (saved_checkpoints[std::get<1>(*idx_iter)]->exec_order <= cfi->exec_order))
     {
-      // find the input addresses of the checkpoint
-      input_dep_addrs.clear();
-      std::for_each(std::begin(chkpnt->input_dep_original_values),
-                    std::end(chkpnt->input_dep_original_values),
-                    [&input_dep_addrs](decltype(chkpnt->input_dep_original_values)::const_reference addr_val)
-      {
-        input_dep_addrs.insert(std::get<0>(addr_val));
-      });
-//      auto addr_iter = chkpnt->input_dep_original_values.begin();
-//      for (; addr_iter != chkpnt->input_dep_original_values.end(); ++addr_iter)
-//      {
-//        input_dep_addrs.insert(addr_iter->first);
-//      }
-
-      // find the intersection between the input addresses of the checkpoint and the affecting input
-      // addresses of the CFI
-      intersected_addrs.clear();
-      std::set_intersection(input_dep_addrs.begin(), input_dep_addrs.end(),
-                            dep_addrs.begin(), dep_addrs.end(),
-                            std::inserter(intersected_addrs, intersected_addrs.begin()));
-      // verify if the intersection is not empty
-      if (!intersected_addrs.empty())
-      {
-        // not empty, then the checkpoint and the intersected addrs make a pair, namely when we need
-        // to change the decision of the CFI then we should rollback to the checkpoint and modify some
-        // value at the address of the intersected addrs
-        checkpoint_with_input_addrs = std::make_pair(chkpnt, intersected_addrs);
-        cfi->affecting_checkpoint_addrs_pairs.push_back(checkpoint_with_input_addrs);
-
-        // the addrs in the intersected set are subtracted from the original dep_addrs
-        new_dep_addrs.clear();
-        std::set_difference(dep_addrs.begin(), dep_addrs.end(),
-                            intersected_addrs.begin(), intersected_addrs.end(),
-                            std::inserter(new_dep_addrs, new_dep_addrs.begin()));
-        // if the rest is empty then we have finished
-        if (new_dep_addrs.empty()) return false;
-        // but if it is not empty then we continue to the next checkpoint
-        else dep_addrs = new_dep_addrs;
-      }
+      input_addrs_at_checkpoint_idx[std::get<1>(*idx_iter)].insert(input_addr);
     }
-    return true;
   });
 
-//  for (auto chkpnt_iter = saved_checkpoints.begin(); chkpnt_iter != saved_checkpoints.end();
-//       ++chkpnt_iter)
-//  {
-//    // consider only checkpoints before the CFI
-//    if ((*chkpnt_iter)->exec_order <= cfi->exec_order)
-//    {
-//      // find the input addresses of the checkpoint
-//      input_dep_addrs.clear();
-//      auto addr_iter = (*chkpnt_iter)->input_dep_original_values.begin();
-//      for (; addr_iter != (*chkpnt_iter)->input_dep_original_values.end(); ++addr_iter)
-//      {
-//        input_dep_addrs.insert(addr_iter->first);
-//      }
-
-//      // find the intersection between the input addresses of the checkpoint and the affecting input
-//      // addresses of the CFI
-//      intersected_addrs.clear();
-//      std::set_intersection(input_dep_addrs.begin(), input_dep_addrs.end(),
-//                            dep_addrs.begin(), dep_addrs.end(),
-//                            std::inserter(intersected_addrs, intersected_addrs.begin()));
-//      // verify if the intersection is not empty
-//      if (!intersected_addrs.empty())
-//      {
-//        // not empty, then the checkpoint and the intersected addrs make a pair, namely when we need
-//        // to change the decision of the CFI then we should rollback to the checkpoint and modify some
-//        // value at the address of the intersected addrs
-//        checkpoint_with_input_addrs = std::make_pair(*chkpnt_iter, intersected_addrs);
-//        cfi->affecting_checkpoint_addrs_pairs.push_back(checkpoint_with_input_addrs);
-////#if !defined(NDEBUG)
-////        tfm::format(std::cerr, "the cfi at %d has a checkpoint at %d\n", cfi->exec_order,
-////                    (*chkpnt_iter)->exec_order);
-////#endif
-
-//        // the addrs in the intersected set are subtracted from the original dep_addrs
-//        new_dep_addrs.clear();
-//        std::set_difference(dep_addrs.begin(), dep_addrs.end(),
-//                            intersected_addrs.begin(), intersected_addrs.end(),
-//                            std::inserter(new_dep_addrs, new_dep_addrs.begin()));
-//        // if the rest is empty then we have finished
-//        if (new_dep_addrs.empty()) break;
-//        // but if it is not empty then we continue to the next checkpoint
-//        else dep_addrs = new_dep_addrs;
-//      }
-//    }
-//  }
+  // the pairs are ordered as the checkpoints, namely when we need to change the decision of the CFI
+  // then we should rollback to the checkpoint and modify some value at the address of the paired
+  // addrs
+  std::for_each(std::begin(input_addrs_at_checkpoint_idx), std::end(input_addrs_at_checkpoint_idx),
+                [&](decltype(input_addrs_at_checkpoint_idx)::const_reference idx_addrs)
+  {
+    cfi->affecting_checkpoint_addrs_pairs.push_back(
+          std::make_pair(saved_checkpoints[std::get<0>(idx_addrs)], std::get<1>(idx_addrs)));
+  });
 
   return;
 }
@@ -211,6 +159,11 @@ static auto save_detected_cfis () -> void
 {
   if (ins_at_order.size() > 1)
   {
+    index_checkpoints_by_input_addr();
+
+    // all new CFIs share the same interned input
+    ptr_input_t interned_fresh_input;
+
     auto last_order_ins = *ins_at_order.rbegin();
     std::for_each(ins_at_order.begin(), ins_at_order.end(),
                   [&](decltype(ins_at_order)::const_reference order_ins)
@@ -227,13 +180,16 @@ static auto save_detected_cfis () -> void
           // and if the recasted CFI depends on the input
           if (!new_cfi->input_dep_addrs.empty())
           {
-            // then copy a fresh input for it
-            new_cfi->fresh_input.reset(new UINT8[received_msg_size], std::default_delete<UINT8[]>());
-            std::copy(fresh_input.get(),
-                      fresh_input.get() + received_msg_size, new_cfi->fresh_input.get());
+            // then give it the interned fresh input
+            if (!interned_fresh_input)
+            {
+              interned_fresh_input = intern_input(fresh_input.get(), received_msg_size);
+            }
+            new_cfi->fresh_input = interned_fresh_input;
 
             // set its checkpoints and save it
             set_checkpoints_for_cfi(new_cfi); detected_input_dep_cfis.push_back(new_cfi);
+            index_saved_instance(new_cfi);
 #if !defined(NDEBUG)
             newly_detected_input_dep_cfis.push_back(new_cfi);
 #endif
@@ -260,7 +216,7 @@ static inline auto calculate_path_code () -> void
     // the root path code is one of the exploring CFI: if the current instruction is the
     // exploring CFI then "1" should be appended into the path code (because "0" has been
     // appended in the previous tainting phase)
-    if (exploring_cfi) current_path_code.push_back(true);
+    if (exploring_cfi) current_path_code = extended_path_code(current_path_code, true);
 
 //    typedef decltype(ins_at_order) ins_at_order_t;
     decltype(ins_at_order)::mapped_type prev_ins;
@@ -270,20 +226,19 @@ static inline auto calculate_path_code () -> void
       if (!exploring_cfi || (exploring_cfi && (std::get<0>(order_ins) > exploring_cfi->exec_order)))
       {
 #if !defined(DISABLE_FSA)
-        explored_fsa->add_vertex(std::get<1>(order_ins));
+        post_fsa_vertex(std::get<1>(order_ins));
         if (prev_ins)
         {
-          explored_fsa->add_edge(prev_ins->address, order_ins.second->address, current_path_code);
-          explored_fsa->add_edge(prev_ins, order_ins.second, current_path_code);
+          post_fsa_edge(prev_ins->address, order_ins.second->address, current_path_code);
+          post_fsa_edge(prev_ins, order_ins.second, current_path_code);
         }
         else
         {
           if (exploring_cfi)
           {
-            explored_fsa->add_edge(exploring_cfi->address, order_ins.second->address,
-                                   current_path_code);
-            explored_fsa->add_edge(std::dynamic_pointer_cast<instruction>(exploring_cfi),
-                                   order_ins.second, current_path_code);
+            post_fsa_edge(exploring_cfi->address, order_ins.second->address, current_path_code);
+            post_fsa_edge(std::dynamic_pointer_cast<instruction>(exploring_cfi),
+                          order_ins.second, current_path_code);
           }
         }
 #endif
@@ -294,7 +249,8 @@ static inline auto calculate_path_code () -> void
           auto current_cfi = std::static_pointer_cast<cond_direct_instruction>(order_ins.second);
           if (!current_cfi->input_dep_addrs.empty())
           {
-            current_cfi->path_code = current_path_code; current_path_code.push_back(false);
+            current_cfi->path_code = current_path_code;
+            current_path_code = extended_path_code(current_path_code, false);
           }
         }
         prev_ins = std::get<1>(order_ins);
@@ -307,16 +263,22 @@ static inline auto calculate_path_code () -> void
 
 
 /**
- * @brief analyze_executed_instructions
+ * @brief analyze_executed_instructions, the input dependency of CFIs is determined from the tainting
+ * graph only if the graph is built, otherwise it has been propagated along the execution.
  */
 static inline auto analyze_executed_instructions () -> void
 {
-  if (!exploring_cfi)
+  if (tainting_graph_knob.Value())
   {
-    save_tainting_graph(dta_graph, process_id_str + "_path_explorer_tainting_graph.dot");
+    if (!exploring_cfi)
+    {
+      save_tainting_graph(dta_graph, process_id_str + "_path_explorer_tainting_graph.dot");
+    }
+    determine_cfi_input_dependency();
   }
-  determine_cfi_input_dependency(); save_detected_cfis();
+  // the path codes of new CFIs are calculated before they are saved (and indexed by path codes)
   calculate_path_code();
+  save_detected_cfis();
 
 //  current_exec_path = std::make_shared<execution_path>(ins_at_order, current_path_code);
 
@@ -405,7 +367,6 @@ static auto prepare_new_rollbacking_phase() -> void
 #endif
 
     // and rollback to the first checkpoint (tainting->rollbacking transition)
-     PIN_RemoveInstrumentation();
      rollback_with_current_input(saved_checkpoints[0], current_exec_order);
   }
 
@@ -473,23 +434,20 @@ auto generic_instruction (ADDRINT ins_addr, const CONTEXT* p_ctxt, THREADID thre
           ins_at_order[current_exec_order] = std::make_shared<instruction>(*ins_at_addr[ins_addr]);
         }
 
-#if !defined(NDEBUG)
-        tfm::format(log_file, "%-4d %-15s %-50s ", current_exec_order,
-                    addrint_to_hexstring(ins_addr), ins_at_addr[ins_addr]->disassembled_name);
-        std::for_each(ins_at_addr[ins_addr]->src_operands.begin(),
-                      ins_at_addr[ins_addr]->src_operands.end(), [&](ptr_operand_t opr)
+        if (event_log_is_enabled())
         {
-          if ((opr->value.type() == typeid(REG)) &&
-              !REG_is_fr_or_x87(boost::get<REG>(opr->exact_value)))
+          log_event(instruction_event, current_exec_order, ins_addr, 0);
+          std::for_each(ins_at_addr[ins_addr]->src_operands.begin(),
+                        ins_at_addr[ins_addr]->src_operands.end(), [&](ptr_operand_t opr)
           {
-            tfm::format(log_file, "(%s: %s)", opr->name,
-                        addrint_to_hexstring(PIN_GetContextReg(p_ctxt, boost::get<REG>(opr->value))));
-          }
-        });
-
-        tfm::format(log_file, " %-25s %-25s\n", ins_at_addr[ins_addr]->contained_image,
-                    ins_at_addr[ins_addr]->contained_function);
-#endif
+            if ((opr->value.type() == typeid(REG)) &&
+                !REG_is_fr_or_x87(boost::get<REG>(opr->exact_value)))
+            {
+              log_event(register_event, current_exec_order, boost::get<REG>(opr->value),
+                        PIN_GetContextReg(p_ctxt, boost::get<REG>(opr->value)));
+            }
+          });
+        }
       }
     }
     else
@@ -504,34 +462,52 @@ auto generic_instruction (ADDRINT ins_addr, const CONTEXT* p_ctxt, THREADID thre
 
 
 /**
- * @brief in the tainting phase, the memory read analysis is used to:
- *  save a checkpoint each time the instruction read some memory addresses in the input buffer, and
- *  update source operands of the instruction as read memory addresses.
+ * @brief verify if the instruction read some addresses in the input buffer; the predicate is
+ * inlined as the "if" part of input_read_instruction, so the context is materialized only for
+ * instructions reading the input.
  */
-auto mem_read_instruction (ADDRINT ins_addr, ADDRINT mem_read_addr, UINT32 mem_read_size,
-                           const CONTEXT* p_ctxt, THREADID thread_id) -> VOID
+auto input_reading_predicate (ADDRINT mem_read_addr, UINT32 mem_read_size) -> ADDRINT
+{
+  return ((mem_read_addr < received_msg_addr + received_msg_size) &&
+          (received_msg_addr < mem_read_addr + mem_read_size));
+}
+
+
+/**
+ * @brief in the tainting phase, a checkpoint is saved each time the instruction read some memory
+ * addresses in the input buffer.
+ */
+auto input_read_instruction (ADDRINT ins_addr, ADDRINT mem_read_addr, UINT32 mem_read_size,
+                             const CONTEXT* p_ctxt, THREADID thread_id) -> VOID
 {
   if (thread_id == traced_thread_id)
   {
-    // verify if the instruction read some addresses in the input buffer
-    if (std::max(mem_read_addr, received_msg_addr) <
-        std::min(mem_read_addr + mem_read_size, received_msg_addr + received_msg_size))
-    {
-      // yes, then save a checkpoint
-      ptr_checkpoint_t new_ptr_checkpoint(new checkpoint(current_exec_order,
-                                                         p_ctxt, mem_read_addr, mem_read_size));
-      saved_checkpoints.push_back(new_ptr_checkpoint);
+    ptr_checkpoint_t new_ptr_checkpoint(new checkpoint(current_exec_order,
+                                                       p_ctxt, mem_read_addr, mem_read_size));
+    saved_checkpoints.push_back(new_ptr_checkpoint);
 
-#if !defined(NDEBUG)
-      tfm::format(log_file, "checkpoint detected at %d because memory is read ",
-                  new_ptr_checkpoint->exec_order);
+    if (event_log_is_enabled())
+    {
+      log_event(checkpoint_event, new_ptr_checkpoint->exec_order, mem_read_addr, mem_read_size);
       for (auto mem_idx = 0; mem_idx < mem_read_size; ++mem_idx)
-        tfm::format(log_file, "(%s: %d)", addrint_to_hexstring(mem_read_addr + mem_idx),
-                    *(reinterpret_cast<UINT8*>(mem_read_addr + mem_idx)));
-      log_file << "\n";
-#endif
+        log_event(memory_event, new_ptr_checkpoint->exec_order, mem_read_addr + mem_idx,
+                  *(reinterpret_cast<UINT8*>(mem_read_addr + mem_idx)));
     }
+  }
+
+  return;
+}
+
 
+/**
+ * @brief in the tainting phase, the memory read analysis is used to update source operands of the
+ * instruction as read memory addresses.
+ */
+auto mem_read_instruction (ADDRINT ins_addr, ADDRINT mem_read_addr, UINT32 mem_read_size,
+                           THREADID thread_id) -> VOID
+{
+  if (thread_id == traced_thread_id)
+  {
     // update source operands
     for (auto addr_offset = 0; addr_offset < mem_read_size; ++addr_offset)
     {
@@ -550,7 +526,7 @@ auto mem_read_instruction (ADDRINT ins_addr, ADDRINT mem_read_addr, UINT32 mem_r
  *  update destination operands of the instruction as written memory addresses.
  */
 auto mem_write_instruction(ADDRINT ins_addr, ADDRINT mem_written_addr, UINT32 mem_written_size,
-                           THREADID thread_id) -> VOID
+                           ADDRINT stack_ptr, THREADID thread_id) -> VOID
 {
   if (thread_id == traced_thread_id)
   {
@@ -575,6 +551,11 @@ auto mem_write_instruction(ADDRINT ins_addr, ADDRINT mem_written_addr, UINT32 me
                                                               mem_written_addr + addr_offset));
     }
   }
+  else
+  {
+    // other threads track memory write operations in their own logs
+    thread_mem_write_tracking(thread_id, mem_written_addr, mem_written_size, stack_ptr);
+  }
 
   return;
 }
@@ -716,6 +697,48 @@ auto graphical_propagation (ADDRINT ins_addr, THREADID thread_id) -> VOID
 }
 
 
+/**
+ * @brief shadow_propagation: the label of the destination operands is the union of the labels of
+ * the source operands, a CFI depends on the input addresses of its source label.
+ * @param ins_addr
+ * @return
+ */
+auto shadow_propagation (ADDRINT ins_addr, THREADID thread_id) -> VOID
+{
+  if (thread_id == traced_thread_id)
+  {
+    auto executed_ins = ins_at_order[current_exec_order];
+
+    ptr_taint_label_t src_label;
+    std::for_each(executed_ins->src_operands.begin(), executed_ins->src_operands.end(),
+                  [&](ptr_operand_t opr)
+    {
+      src_label = merged_taint_label(src_label, (opr->value.type() == typeid(REG)) ?
+                                       reg_taint_label(boost::get<REG>(opr->value)) :
+                                       mem_taint_label(boost::get<ADDRINT>(opr->value)));
+    });
+
+    std::for_each(executed_ins->dst_operands.begin(), executed_ins->dst_operands.end(),
+                  [&](ptr_operand_t opr)
+    {
+      if (opr->value.type() == typeid(REG))
+        set_reg_taint_label(boost::get<REG>(opr->value), src_label);
+      else set_mem_taint_label(boost::get<ADDRINT>(opr->value), src_label);
+    });
+
+    // consider only the CFI that is beyond the exploring CFI
+    if (src_label && executed_ins->is_cond_direct_cf &&
+        (!exploring_cfi || (current_exec_order > exploring_cfi->exec_order)))
+    {
+      auto executed_cfi = std::static_pointer_cast<cond_direct_instruction>(executed_ins);
+      executed_cfi->input_dep_addrs.insert(src_label->begin(), src_label->end());
+    }
+  }
+
+  return;
+}
+
+
 /**
  * @brief initialize_tainting_phase
  */
@@ -723,6 +746,14 @@ void initialize()
 {
   dta_graph.clear(); dta_outer_vertices.clear(); saved_checkpoints.clear(); ins_at_order.clear();
 
+  // each byte of the input depends on its own address
+  clear_taint_shadow();
+  for (auto mem_addr = received_msg_addr; mem_addr < received_msg_addr + received_msg_size;
+       ++mem_addr)
+  {
+    set_mem_taint_label(mem_addr, std::make_shared<std::set<ADDRINT>>(&mem_addr, &mem_addr + 1));
+  }
+
 #if !defined(NDEBUG)
   newly_detected_input_dep_cfis.clear(); newly_detected_cfis.clear();
 #endif
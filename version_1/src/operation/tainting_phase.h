@@ -13,13 +13,21 @@ extern auto kernel_mapped_instruction (ADDRINT ins_addr, THREADID thread_id)
 extern auto generic_instruction       (ADDRINT ins_addr, const CONTEXT* p_ctxt,
                                        THREADID thread_id)                          -> VOID;
 
-extern auto mem_read_instruction      (ADDRINT ins_addr, ADDRINT mem_read_addr,
+extern auto input_reading_predicate   (ADDRINT mem_read_addr, UINT32 mem_read_size) -> ADDRINT;
+
+extern auto input_read_instruction    (ADDRINT ins_addr, ADDRINT mem_read_addr,
                                        UINT32 mem_read_size, const CONTEXT* p_ctxt,
                                        THREADID thread_id)                          -> VOID;
 
+extern auto mem_read_instruction      (ADDRINT ins_addr, ADDRINT mem_read_addr,
+                                       UINT32 mem_read_size, THREADID thread_id)    -> VOID;
+
 extern auto mem_write_instruction     (ADDRINT ins_addr, ADDRINT mem_written_addr,
-                                       UINT32 mem_written_size, THREADID thread_id) -> VOID;
+                                       UINT32 mem_written_size, ADDRINT stack_ptr,
+                                       THREADID thread_id)                          -> VOID;
 
 extern auto graphical_propagation     (ADDRINT ins_addr, THREADID thread_id)        -> VOID;
+
+extern auto shadow_propagation        (ADDRINT ins_addr, THREADID thread_id)        -> VOID;
 } // end of tainting namespace
 #endif
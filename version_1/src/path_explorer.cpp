@@ -1,6 +1,8 @@
 #include "operation/instrumentation.h"
 #include "operation/tainting_phase.h"
 #include "operation/capturing_phase.h"
+#include "operation/exploring_scheduler.h"
+#include "operation/exploring_workers.h"
 #include "common.h"
 #include "util/stuffs.h"
 #include <ctime>
@@ -25,7 +27,7 @@ ptr_cond_direct_inss_t  detected_input_dep_cfis;
 ptr_cond_direct_ins_t   exploring_cfi;
 
 UINT32                  current_exec_order;
-path_code_t             current_path_code;
+path_code_id_t          current_path_code;
 ptr_explorer_graph_t    explored_fsa;
 
 ptr_exec_dfa_t          abstracted_dfa;
@@ -77,6 +79,36 @@ KNOB<UINT32> max_trace_length_knob         (KNOB_MODE_WRITEONCE, "pintool", "l",
 KNOB<UINT32> interested_input_order_knob   (KNOB_MODE_WRITEONCE, "pintool", "i", "1",
                                             "specify the order of the treated input");
 
+KNOB<FLT64>  giveup_probability_knob       (KNOB_MODE_WRITEONCE, "pintool", "p", "0.001",
+                                            "specify the flipping probability under which a CFI is given up (0 to disable)");
+
+KNOB<std::string> instruction_cache_knob   (KNOB_MODE_WRITEONCE, "pintool", "c", "",
+                                            "specify the directory of cached instructions (empty to disable)");
+
+KNOB<BOOL>   tainting_graph_knob           (KNOB_MODE_WRITEONCE, "pintool", "g", "0",
+                                            "specify whether the tainting graph is built and saved");
+
+KNOB<BOOL>   event_log_knob                (KNOB_MODE_WRITEONCE, "pintool", "e", "0",
+                                            "specify whether executed instructions and checkpoints are logged as binary events");
+
+KNOB<BOOL>   bisection_knob                (KNOB_MODE_WRITEONCE, "pintool", "b", "0",
+                                            "specify whether the input partitions of 1 or 2 bytes CFIs are discovered by bisection");
+
+KNOB<UINT32> worker_num_knob               (KNOB_MODE_WRITEONCE, "pintool", "w", "1",
+                                            "specify the number of workers forked to explore the first trace in parallel (Linux only)");
+
+KNOB<std::string> scheduling_policy_knob   (KNOB_MODE_WRITEONCE, "pintool", "s", "order",
+                                            "specify the policy selecting the next explored CFI (order, novelty, depth or width)");
+
+KNOB<BOOL>   fsa_knob                      (KNOB_MODE_WRITEONCE, "pintool", "f", "1",
+                                            "specify whether the explored FSA is reconstructed (by a background thread)");
+
+KNOB<BOOL>   path_instructions_knob        (KNOB_MODE_WRITEONCE, "pintool", "a", "0",
+                                            "specify whether explored paths keep all instructions (only CFIs otherwise)");
+
+KNOB<BOOL>   dfa_minimization_knob         (KNOB_MODE_WRITEONCE, "pintool", "o", "0",
+                                            "specify whether the raw DFA is minimized (and saved) before being abstracted");
+
 /* ---------------------------------------------------------------------------------------------- */
 /*                                  basic instrumentation functions                               */
 /* ---------------------------------------------------------------------------------------------- */
@@ -117,8 +149,23 @@ auto start_exploring (VOID *data) -> VOID
   log_file.open(process_id_str + "_path_explorer.log", std::ofstream::out | std::ofstream::trunc);
   if (!log_file) PIN_ExitProcess(1);
 
-  tfm::format(log_file, "total rollback %d, local rollback %d, trace depth %d, ",
-              max_total_rollback_times, max_local_rollback_times, max_trace_size);
+  if (!initialize_workers(worker_num_knob.Value()))
+  {
+    tfm::format(log_file, "fatal: unsupported number of workers %d\n", worker_num_knob.Value());
+    PIN_ExitProcess(1);
+  }
+
+  if (!initialize_scheduler(scheduling_policy_knob.Value()))
+  {
+    tfm::format(log_file, "fatal: unknown scheduling policy %s\n", scheduling_policy_knob.Value());
+    PIN_ExitProcess(1);
+  }
+
+  tfm::format(log_file, "total rollback %d, local rollback %d, trace depth %d, give-up probability %g, ",
+              max_total_rollback_times, max_local_rollback_times, max_trace_size,
+              giveup_probability_knob.Value());
+  tfm::format(log_file, "%d workers, scheduling policy %s, ", worker_num_knob.Value(),
+              scheduling_policy_knob.Value());
 
 #if !defined(ENABLE_FAST_ROLLBACK)
   tfm::format(log_file, "fast rollback disabled, ");
@@ -127,14 +174,20 @@ auto start_exploring (VOID *data) -> VOID
 #endif
 
 #if !defined(DISABLE_FSA)
-  tfm::format(log_file, "FSA reconstruction enabled\n");
-#elif
+  if (fsa_knob.Value()) tfm::format(log_file, "FSA reconstruction enabled\n");
+  else tfm::format(log_file, "FSA reconstruction disabled\n");
+#else
   tfm::format(log_file, "FSA reconstruction disabled\n");
 #endif
   tfm::format(log_file, "======================================================================\n");
 //  log_file << "=================================================================================\n";
 
   instrumentation::initialize();
+  initialize_instruction_cache(instruction_cache_knob.Value());
+  if (event_log_knob.Value()) start_event_log(process_id_str + "_path_explorer.events");
+#if !defined(DISABLE_FSA)
+  if (fsa_knob.Value()) start_fsa_builder();
+#endif
 
 //  start_time = std::time(0); std::srand(static_cast<unsigned int>(start_time));
 //  ptr_rand_engine = std::make_shared<std::default_random_engine>(std::random_device()());
@@ -164,14 +217,18 @@ auto stop_exploring (INT32 code, VOID *data) -> VOID
 //  save_received_message("message_" + process_id_str + ".log");
 
 #if !defined(DISABLE_FSA)
-  tfm::format(std::cerr, "extracting CFI tree\n");
-  explored_fsa->extract_cfi_tree();
+  // the FSA builder has applied all posted updates before the application exits
+  if (fsa_builder_is_enabled())
+  {
+    tfm::format(std::cerr, "extracting CFI tree\n");
+    explored_fsa->extract_cfi_tree();
 
-//  tfm::format(std::cerr, "saving CFI inputs\n");
-//  save_cfi_inputs(process_id_str + "_cfi_inputs.log");
+//    tfm::format(std::cerr, "saving CFI inputs\n");
+//    save_cfi_inputs(process_id_str + "_cfi_inputs.log");
 
-  tfm::format(std::cerr, "saving all trees\n");
-  explored_fsa->save_to_file(process_id_str + "_path_explorer_explored_fsa.dot");
+    tfm::format(std::cerr, "saving all trees\n");
+    explored_fsa->save_to_file(process_id_str + "_path_explorer_explored_fsa.dot");
+  }
 #endif
 
   UINT32 resolved_cfi_num = 0, singular_cfi_num = 0;
@@ -185,26 +242,35 @@ auto stop_exploring (INT32 code, VOID *data) -> VOID
   tfm::format(log_file, "%d seconds elapsed, %d rollbacks used, %d/%d/%d resolved/singular/total CFI.\n",
               (stop_time - start_time), total_rollback_times, resolved_cfi_num, singular_cfi_num,
               detected_input_dep_cfis.size());
+  tfm::format(log_file, "%d explored paths stored in %d nodes.\n", explored_exec_paths.size(),
+              exec_path_node_num() - 1);
   log_file.close();
 
-  calculate_exec_path_conditions(explored_exec_paths);
+  // the explored paths and the FSA updates of a worker have been sent to its coordinator, which
+  // builds the DFA and the explored FSA (and keeps the instruction cache)
+  if (is_exploring_worker()) return;
 
-//  show_cfi_logged_inputs();
-  tfm::format(std::cerr, "constructing raw DFA\n");
-  abstracted_dfa->add_exec_paths(explored_exec_paths);
+  save_instruction_cache();
+  save_scheduling_statistics(process_id_str + "_path_explorer.schedule");
+  if (event_log_knob.Value()) save_event_symbols(process_id_str + "_path_explorer.symbols");
 
+//  show_cfi_logged_inputs();
+  // the raw DFA has been constructed while exploring, each explored path is inserted into it
   tfm::format(std::cerr, "pre-processing some states\n");
   abstracted_dfa->pre_processing();
 
   tfm::format(std::cerr, "saving raw DFA to file\n");
   abstracted_dfa->save_to_file("raw_" + process_id_str + ".dot");
 
-//  tfm::format(std::cerr, "optimizing raw DFA\n");
-//  abstracted_dfa->optimize();
-//  abstracted_dfa->co_optimize();
+  if (dfa_minimization_knob.Value())
+  {
+    tfm::format(std::cerr, "optimizing raw DFA\n");
+//    abstracted_dfa->optimize();
+    abstracted_dfa->co_optimize();
 
-//  tfm::format(std::cerr, "saving optimized DFA to file\n");
-//  abstracted_dfa->save_to_file("optimized_" + process_id_str + ".dot");
+    tfm::format(std::cerr, "saving optimized DFA to file\n");
+    abstracted_dfa->save_to_file("optimized_" + process_id_str + ".dot");
+  }
 
   tfm::format(std::cerr, "abstracting DFA\n");
 //  abstracted_dfa->approximate();
@@ -212,6 +278,7 @@ auto stop_exploring (INT32 code, VOID *data) -> VOID
 
   tfm::format(std::cerr, "saving abstracted DFA to file\n");
   abstracted_dfa->save_to_file("abstracted_" + process_id_str + ".dot");
+  abstracted_dfa->save_to_table("abstracted_" + process_id_str + ".table");
 
   stop_time = std::time(0);
   tfm::format(std::cerr, "%d seconds elapsed for abstracting DFA\n", stop_time - start_time);
@@ -240,14 +307,18 @@ int main(int argc, char *argv[])
     tfm::format(std::cerr, "activate Pintool data-initialization\n");
     PIN_AddApplicationStartFunction(start_exploring, 0);  // 0 is the (unused) input data
 
+    tfm::format(std::cerr, "activate thread memory logs\n");
+    initialize_thread_memory_logs();
+
     tfm::format(std::cerr, "activate image-loading instrumenter\n");
     IMG_AddInstrumentFunction(instrumentation::image_loading, 0);
 
 //    tfm::format(std::cerr, "activate routine-calling instrumenters\n"); (never active this!!!)
 //    RTN_AddInstrumentFunction(instrumentation::routine_calling, 0);
 
-    tfm::format(std::cerr, "activate instruction-executing instrumenters\n");
-    INS_AddInstrumentFunction(instrumentation::instruction_executing, 0);
+    tfm::format(std::cerr, "activate trace-executing instrumenters\n");
+    instrumentation::claim_phase_register();
+    TRACE_AddInstrumentFunction(instrumentation::trace_executing, 0);
 
     tfm::format(std::cerr, "activate process-creating instrumenter\n");
     PIN_AddFollowChildProcessFunction(instrumentation::process_creating, 0);
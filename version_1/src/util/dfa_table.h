@@ -0,0 +1,27 @@
+#ifndef DFA_TABLE_H
+#define DFA_TABLE_H
+
+// the layout of the binary transition table of the abstracted DFA is shared by the pintool and the
+// standalone matcher, so it uses only standard fixed-width types. A table file consists of
+//   - a dfa_table_header_t,
+//   - the byte classes: 256 x uint8_t, the class of each byte value,
+//   - the accepting flags: state_num x uint8_t,
+//   - the transitions: state_num x class_num x uint32_t (row-major), the next state of each state
+//     at each byte class, or dfa_table_reject
+// all integers are in the byte order of the host (little endian on x86)
+#include <stdint.h>
+
+static const uint32_t dfa_table_magic   = 0x54444550; // "PEDT"
+static const uint32_t dfa_table_version = 1;
+static const uint32_t dfa_table_reject  = 0xffffffff;
+
+typedef struct
+{
+  uint32_t  magic;
+  uint32_t  version;
+  uint32_t  state_num;
+  uint32_t  class_num;
+  uint32_t  initial_state;
+}                           dfa_table_header_t;
+
+#endif // DFA_TABLE_H
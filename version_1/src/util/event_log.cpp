@@ -0,0 +1,139 @@
+#include "event_log.h"
+#include "../common.h"
+
+#include <atomic>
+#include <fstream>
+#include <algorithm>
+
+/*================================================================================================*/
+
+// events are written by the traced thread into a ring buffer (a single producer) and drained into
+// the event file by an internal thread (a single consumer), so the ring needs no lock: the writer
+// owns write_idx, the drainer owns read_idx
+static const UINT64         ring_size = 1 << 16;
+static event_record_t       event_ring[ring_size];
+static std::atomic<UINT64>  write_idx(0);
+static std::atomic<UINT64>  read_idx(0);
+
+static std::atomic<bool>    drainer_is_stopped(false);
+static bool                 event_log_is_started = false;
+static bool                 event_log_is_closed = false;
+static PIN_THREAD_UID       drainer_uid;
+static std::ofstream        event_file;
+
+/*================================================================================================*/
+
+static auto drain_events (VOID* data) -> VOID
+{
+  while (true)
+  {
+    auto last_idx = write_idx.load(std::memory_order_acquire);
+    auto first_idx = read_idx.load(std::memory_order_relaxed);
+
+    if (first_idx == last_idx)
+    {
+      // the ring is empty, the drainer stops only at this point so that no event is lost
+      if (drainer_is_stopped.load(std::memory_order_acquire)) break;
+      PIN_Sleep(1); continue;
+    }
+
+    // write the events in (at most) two contiguous parts of the ring
+    while (first_idx < last_idx)
+    {
+      auto part_size = std::min(last_idx - first_idx, ring_size - (first_idx & (ring_size - 1)));
+      event_file.write(reinterpret_cast<const char*>(&event_ring[first_idx & (ring_size - 1)]),
+                       part_size * sizeof(event_record_t));
+      first_idx += part_size;
+    }
+    read_idx.store(last_idx, std::memory_order_release);
+  }
+
+  event_file.close();
+  return;
+}
+
+
+static auto stop_event_log (VOID* data) -> VOID
+{
+  if (event_log_is_closed) return;
+
+  event_log_is_closed = true;
+  drainer_is_stopped.store(true, std::memory_order_release);
+  PIN_WaitForThreadTermination(drainer_uid, PIN_INFINITE_TIMEOUT, 0);
+  return;
+}
+
+
+/**
+ * @brief start_event_log, the drainer is an internal thread of the tool
+ */
+auto start_event_log (const std::string& filename) -> void
+{
+  event_file.open(filename.c_str(), std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+  if (event_file)
+  {
+    event_log_is_started = (PIN_SpawnInternalThread(drain_events, 0, 0, &drainer_uid) !=
+                            INVALID_THREADID);
+    if (event_log_is_started) PIN_AddPrepareForFiniFunction(stop_event_log, 0);
+  }
+  return;
+}
+
+
+auto event_log_is_enabled () -> bool
+{
+  return event_log_is_started && !event_log_is_closed;
+}
+
+
+/**
+ * @brief close_event_log: the logged events are drained and the events file is closed before
+ * exploring workers are forked (the drainer is not duplicated by fork), no event is logged then
+ */
+auto close_event_log () -> void
+{
+  if (event_log_is_started) stop_event_log(0);
+  return;
+}
+
+
+/**
+ * @brief log_event, the writer waits only if the ring is full
+ */
+auto log_event (event_type type, UINT32 exec_order, ADDRINT address, ADDRINT value) -> void
+{
+  auto idx = write_idx.load(std::memory_order_relaxed);
+  while (idx - read_idx.load(std::memory_order_acquire) >= ring_size) PIN_Yield();
+
+  auto& record = event_ring[idx & (ring_size - 1)];
+  record.type = type; record.exec_order = exec_order; record.address = address; record.value = value;
+  write_idx.store(idx + 1, std::memory_order_release);
+  return;
+}
+
+
+/**
+ * @brief save the names of instructions and registers referred by events, they are needed by the
+ * offline printer: one "ins <address> <disassembled name> <image> <function>" or
+ * "reg <register> <name>" per line, fields are separated by tabs
+ */
+auto save_event_symbols (const std::string& filename) -> void
+{
+  std::ofstream symbol_file(filename.c_str(), std::ofstream::out | std::ofstream::trunc);
+
+  std::for_each(ins_at_addr.begin(), ins_at_addr.end(), [&](addr_ins_map_t::const_reference addr_ins)
+  {
+    tfm::format(symbol_file, "ins\t%d\t%s\t%s\t%s\n", std::get<0>(addr_ins),
+                std::get<1>(addr_ins)->disassembled_name, std::get<1>(addr_ins)->contained_image,
+                std::get<1>(addr_ins)->contained_function);
+  });
+
+  for (auto reg = static_cast<UINT32>(REG_FIRST); reg <= static_cast<UINT32>(REG_LAST); ++reg)
+  {
+    if (REG_valid(static_cast<REG>(reg)))
+      tfm::format(symbol_file, "reg\t%d\t%s\n", reg, REG_StringShort(static_cast<REG>(reg)));
+  }
+
+  symbol_file.close();
+  return;
+}
@@ -0,0 +1,22 @@
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include "../parsing_helper.h"
+#include <pin.H>
+
+#include <string>
+
+#include "event_record.h"
+
+extern auto start_event_log         (const std::string& filename)                      -> void;
+
+extern auto event_log_is_enabled    ()                                                 -> bool;
+
+extern auto close_event_log         ()                                                 -> void;
+
+extern auto log_event               (event_type type, UINT32 exec_order,
+                                     ADDRINT address, ADDRINT value)                   -> void;
+
+extern auto save_event_symbols      (const std::string& filename)                      -> void;
+
+#endif // EVENT_LOG_H
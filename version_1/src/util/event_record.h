@@ -0,0 +1,24 @@
+#ifndef EVENT_RECORD_H
+#define EVENT_RECORD_H
+
+// the layout of binary events is shared by the pintool and the offline printer, so it uses only
+// standard fixed-width types
+#include <stdint.h>
+
+typedef enum
+{
+  instruction_event = 1,  // exec_order, address: instruction address
+  register_event    = 2,  // exec_order, address: register, value: register value
+  checkpoint_event  = 3,  // exec_order, address: read memory address, value: read size
+  memory_event      = 4   // exec_order, address: memory address, value: byte value
+}                           event_type;
+
+typedef struct
+{
+  uint32_t  type;
+  uint32_t  exec_order;
+  uint64_t  address;
+  uint64_t  value;
+}                           event_record_t;
+
+#endif // EVENT_RECORD_H
@@ -0,0 +1,200 @@
+#include "fsa_builder.h"
+#include "../common.h"
+
+#include <vector>
+#include <algorithm>
+
+/*================================================================================================*/
+
+// updates are posted by the traced thread and applied to the explored FSA by an internal thread
+// (the builder), the builder takes all posted updates at once so the lock is held only to swap
+// the lists
+static fsa_events_t             posted_events;
+static PIN_MUTEX                posted_events_lock;
+static PIN_SEMAPHORE            events_are_posted;
+
+static bool                     builder_is_stopped = false;
+static bool                     builder_is_started = false;
+static PIN_THREAD_UID           builder_uid;
+
+// a forked worker has no builder (the internal thread is not duplicated by fork), its updates are
+// kept until they are taken and sent to the coordinator
+static bool                     events_are_kept = false;
+
+/*================================================================================================*/
+
+static auto apply_event (const fsa_event_t& event) -> void
+{
+  switch (event.type)
+  {
+  case addr_vertex_event:
+    explored_fsa->add_vertex(event.ins_a_addr); break;
+
+  case ins_vertex_event:
+    explored_fsa->add_vertex(event.ins_a); break;
+
+  case addr_edge_event:
+    explored_fsa->add_edge(event.ins_a_addr, event.ins_b_addr, event.path_code, event.phase); break;
+
+  case ins_edge_event:
+    explored_fsa->add_edge(event.ins_a, event.ins_b, event.path_code); break;
+  }
+  return;
+}
+
+
+static auto build_fsa (VOID* data) -> VOID
+{
+  fsa_events_t taken_events;
+  auto is_stopped = false;
+  while (true)
+  {
+    PIN_SemaphoreWait(&events_are_posted);
+
+    // once the builder is stopped the semaphore stays set, so it does not wait anymore
+    PIN_MutexLock(&posted_events_lock);
+    taken_events.swap(posted_events); is_stopped = builder_is_stopped;
+    if (!is_stopped) PIN_SemaphoreClear(&events_are_posted);
+    PIN_MutexUnlock(&posted_events_lock);
+
+    std::for_each(taken_events.begin(), taken_events.end(), apply_event);
+
+    // the builder stops only when all posted events are applied
+    if (taken_events.empty() && is_stopped) break;
+    taken_events.clear();
+  }
+  return;
+}
+
+
+static auto stop_fsa_builder (VOID* data) -> VOID
+{
+  if (!builder_is_started) return;
+
+  PIN_MutexLock(&posted_events_lock);
+  builder_is_stopped = true; PIN_SemaphoreSet(&events_are_posted);
+  PIN_MutexUnlock(&posted_events_lock);
+
+  PIN_WaitForThreadTermination(builder_uid, PIN_INFINITE_TIMEOUT, 0);
+  return;
+}
+
+
+static auto post_event (const fsa_event_t& event) -> void
+{
+  if (builder_is_started)
+  {
+    PIN_MutexLock(&posted_events_lock);
+    posted_events.push_back(event); PIN_SemaphoreSet(&events_are_posted);
+    PIN_MutexUnlock(&posted_events_lock);
+  }
+  else if (events_are_kept) posted_events.push_back(event);
+  return;
+}
+
+/*================================================================================================*/
+
+/**
+ * @brief start_fsa_builder, the explored FSA is complete once the application is about to exit
+ */
+auto start_fsa_builder () -> void
+{
+  PIN_MutexInit(&posted_events_lock); PIN_SemaphoreInit(&events_are_posted);
+  builder_is_started = (PIN_SpawnInternalThread(build_fsa, 0, 0, &builder_uid) != INVALID_THREADID);
+  if (builder_is_started) PIN_AddPrepareForFiniFunction(stop_fsa_builder, 0);
+  return;
+}
+
+
+auto fsa_builder_is_enabled () -> bool
+{
+  return builder_is_started;
+}
+
+
+auto post_fsa_vertex (ADDRINT ins_addr) -> void
+{
+  fsa_event_t event = { addr_vertex_event, ins_addr, 0, ptr_instruction_t(), ptr_instruction_t(),
+                        empty_path_code, static_cast<UINT32>(current_running_phase) };
+  post_event(event);
+  return;
+}
+
+
+auto post_fsa_vertex (ptr_instruction_t ins) -> void
+{
+  fsa_event_t event = { ins_vertex_event, 0, 0, ins, ptr_instruction_t(), empty_path_code,
+                        static_cast<UINT32>(current_running_phase) };
+  post_event(event);
+  return;
+}
+
+
+auto post_fsa_edge (ADDRINT ins_a_addr, ADDRINT ins_b_addr, path_code_id_t edge_path_code) -> void
+{
+  fsa_event_t event = { addr_edge_event, ins_a_addr, ins_b_addr, ptr_instruction_t(),
+                        ptr_instruction_t(), edge_path_code,
+                        static_cast<UINT32>(current_running_phase) };
+  post_event(event);
+  return;
+}
+
+
+auto post_fsa_edge (ptr_instruction_t ins_a, ptr_instruction_t ins_b,
+                    path_code_id_t edge_path_code) -> void
+{
+  fsa_event_t event = { ins_edge_event, 0, 0, ins_a, ins_b, edge_path_code,
+                        static_cast<UINT32>(current_running_phase) };
+  post_event(event);
+  return;
+}
+
+
+/**
+ * @brief post an update received from a forked worker, its phase is the one in the worker
+ */
+auto post_fsa_event (const fsa_event_t& event) -> void
+{
+  post_event(event);
+  return;
+}
+
+
+/**
+ * @brief hold_fsa_events: the posted updates are locked before forking workers, so that no worker
+ * copies them while the builder is swapping them
+ */
+auto hold_fsa_events () -> void
+{
+  if (builder_is_started) PIN_MutexLock(&posted_events_lock);
+  return;
+}
+
+
+/**
+ * @brief release_fsa_events: after forking, the coordinator keeps its builder; a worker drops the
+ * copied updates (they are applied by the coordinator) and keeps its own ones
+ */
+auto release_fsa_events (bool in_forked_worker) -> void
+{
+  if (builder_is_started)
+  {
+    if (in_forked_worker)
+    {
+      posted_events.clear(); builder_is_started = false; events_are_kept = true;
+    }
+    PIN_MutexUnlock(&posted_events_lock);
+  }
+  return;
+}
+
+
+/**
+ * @brief the updates kept by a forked worker since they were last taken
+ */
+auto taken_fsa_events () -> fsa_events_t
+{
+  fsa_events_t taken_events;
+  taken_events.swap(posted_events);
+  return taken_events;
+}
@@ -0,0 +1,56 @@
+#ifndef FSA_BUILDER_H
+#define FSA_BUILDER_H
+
+#include "../parsing_helper.h"
+#include <pin.H>
+
+#include "../base/instruction.h"
+#include "../base/path_code_trie.h"
+
+#include <vector>
+
+typedef enum
+{
+  addr_vertex_event = 0,
+  ins_vertex_event  = 1,
+  addr_edge_event   = 2,
+  ins_edge_event    = 3
+}                               fsa_event_type;
+
+// an update of the explored FSA, the running phase is the one when the update is posted
+typedef struct
+{
+  fsa_event_type    type;
+  ADDRINT           ins_a_addr;
+  ADDRINT           ins_b_addr;
+  ptr_instruction_t ins_a;
+  ptr_instruction_t ins_b;
+  path_code_id_t    path_code;
+  UINT32            phase;
+} fsa_event_t;
+
+typedef std::vector<fsa_event_t> fsa_events_t;
+
+extern auto start_fsa_builder       ()                                                 -> void;
+
+extern auto fsa_builder_is_enabled  ()                                                 -> bool;
+
+extern auto post_fsa_vertex         (ADDRINT ins_addr)                                 -> void;
+
+extern auto post_fsa_vertex         (ptr_instruction_t ins)                            -> void;
+
+extern auto post_fsa_edge           (ADDRINT ins_a_addr, ADDRINT ins_b_addr,
+                                     path_code_id_t edge_path_code)                    -> void;
+
+extern auto post_fsa_edge           (ptr_instruction_t ins_a, ptr_instruction_t ins_b,
+                                     path_code_id_t edge_path_code)                    -> void;
+
+extern auto post_fsa_event          (const fsa_event_t& event)                         -> void;
+
+extern auto hold_fsa_events         ()                                                 -> void;
+
+extern auto release_fsa_events      (bool in_forked_worker)                            -> void;
+
+extern auto taken_fsa_events        ()                                                 -> fsa_events_t;
+
+#endif // FSA_BUILDER_H
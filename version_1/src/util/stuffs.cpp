@@ -1,7 +1,13 @@
 #include "../common.h"
+#include "../base/value_set_label.h"
 #include <boost/graph/graphviz.hpp>
+#include <boost/unordered_map.hpp>
 #include <cstdint>
 
+// saved CFI instances indexed by their address, execution order and path code
+typedef std::pair<std::pair<ADDRINT, UINT32>, path_code_id_t>                 cfi_instance_key_t;
+static boost::unordered_map<cfi_instance_key_t, ptr_cond_direct_ins_t>        saved_instance_at_key;
+
 auto addrint_to_hexstring (ADDRINT input) -> std::string
 {
 //  std::stringstream num_stream;
@@ -32,6 +38,16 @@ auto path_code_to_string  (const path_code_t& path_code) -> std::string
 }
 
 
+/**
+ * @brief extend the rolling hash of an executed path by the address of the next instruction, a
+ * path of n instructions is hashed as a polynomial of degree n over instruction addresses
+ */
+auto extend_path_hash (path_hash_t path_hash, ADDRINT ins_addr) -> path_hash_t
+{
+  return path_hash * static_cast<path_hash_t>(0x01000193) + ins_addr;
+}
+
+
 /**
  * @brief verify if two map a and b are exactly equal, inspired from http://goo.gl/9W8Ws7
  */
@@ -68,38 +84,24 @@ auto two_maps_are_isomorphic (const addrint_value_map_t& map_a,
 
 
 /**
- * @brief two_vmaps_are_isomorphic
+ * @brief two_vmaps_are_isomorphic, by comparing their canonical labels
  */
 auto two_vmaps_are_isomorphic (const addrint_value_maps_t& maps_a,
                                const addrint_value_maps_t& maps_b) -> bool
 {
-  auto map_a_in_maps_b = [&](addrint_value_maps_t::const_reference map_a) -> bool
-  {
-    return (std::find_if(std::begin(maps_b), std::end(maps_b),
-                         std::bind(two_maps_are_isomorphic, map_a, std::placeholders::_1))
-            != std::end(maps_b));
-  };
-
   return ((maps_a.size() == maps_b.size()) &&
-          std::all_of(std::begin(maps_a), std::end(maps_a), map_a_in_maps_b));
+          (value_set_label(maps_a) == value_set_label(maps_b)));
 }
 
 
 /**
- * @brief a_vmaps_is_included_in_b
+ * @brief a_vmaps_is_included_in_b, by comparing their canonical labels
  */
 auto a_vmaps_is_included_in_b (const addrint_value_maps_t& maps_a,
                                const addrint_value_maps_t& maps_b) -> bool
 {
-  auto map_a_in_maps_b = [&](addrint_value_maps_t::const_reference map_a) -> bool
-  {
-    return (std::find_if(std::begin(maps_b), std::end(maps_b),
-                        std::bind(two_maps_are_isomorphic, map_a, std::placeholders::_1))
-            != std::end(maps_b));
-  };
-
   return ((maps_a.size() < maps_b.size()) &&
-          std::all_of(std::begin(maps_a), std::end(maps_a), map_a_in_maps_b));
+          value_set_label(maps_a).is_included_in(value_set_label(maps_b)));
 }
 
 
@@ -125,27 +127,39 @@ auto is_resolved_cfi (ptr_instruction_t tested_ins) -> bool
 
 
 /**
- * @brief look_for_saved_cfi_instance
+ * @brief index_saved_instance, the first saved instance of a key is kept
+ */
+auto index_saved_instance (const ptr_cond_direct_ins_t cfi) -> void
+{
+  saved_instance_at_key.insert(std::make_pair(
+      std::make_pair(std::make_pair(cfi->address, cfi->exec_order), cfi->path_code), cfi));
+  return;
+}
+
+
+/**
+ * @brief look_for_saved_cfi_instance, the path code is the one of the instance (i.e. the prefix of
+ * the path code of an execution path before the CFI)
  */
 auto look_for_saved_instance (const ptr_cond_direct_ins_t cfi,
-                              const path_code_t path_code) -> ptr_cond_direct_ins_t
+                              path_code_id_t path_code) -> ptr_cond_direct_ins_t
 {
 //  tfm::format(std::cerr, "path code: %s\n", path_code_to_string(path_code));
 
-  auto predicate = [&cfi,&path_code](ptr_cond_direct_ins_t examined_cfi) -> bool
-  {
-//    tfm::format(std::cerr, "examined path code: %s\n", path_code_to_string(examined_cfi->path_code));
+  return look_for_saved_instance(cfi->address, cfi->exec_order, path_code);
+}
 
-    return ((cfi->address == examined_cfi->address) &&
-            (cfi->exec_order == examined_cfi->exec_order) &&
-            std::equal(examined_cfi->path_code.begin(),
-                       examined_cfi->path_code.end(), path_code.begin()));
-  };
 
+/**
+ * @brief look_for_saved_instance by the key of the instance
+ */
+auto look_for_saved_instance (ADDRINT cfi_addr, UINT32 cfi_order,
+                              path_code_id_t path_code) -> ptr_cond_direct_ins_t
+{
   ptr_cond_direct_ins_t result_cfi;
-  auto result_cfi_iter = std::find_if(detected_input_dep_cfis.begin(),
-                                      detected_input_dep_cfis.end(), predicate);
-  if (result_cfi_iter != detected_input_dep_cfis.end()) result_cfi = *result_cfi_iter;
+  auto result_cfi_iter = saved_instance_at_key.find(
+        std::make_pair(std::make_pair(cfi_addr, cfi_order), path_code));
+  if (result_cfi_iter != saved_instance_at_key.end()) result_cfi = result_cfi_iter->second;
   return result_cfi;
 }
 
@@ -331,7 +345,7 @@ auto save_cfi_inputs (const std::string& filename) -> void
       });
     };
 
-    auto generic_filename = path_code_to_string(cfi->path_code) + "_" +
+    auto generic_filename = path_code_to_string(path_code_bits(cfi->path_code)) + "_" +
         addrint_to_hexstring(cfi->address)  + "_" + filename;
 
     std::ofstream first_output_file(("0_" + generic_filename).c_str(),
@@ -7,6 +7,8 @@ auto addrint_to_hexstring       (ADDRINT input)                -> std::string;
 
 auto path_code_to_string        (const path_code_t& path_code) -> std::string;
 
+auto extend_path_hash           (path_hash_t path_hash, ADDRINT ins_addr) -> path_hash_t;
+
 auto two_maps_are_identical     (const addrint_value_map_t& map_a,
                                  const addrint_value_map_t& map_b) -> bool;
 
@@ -23,8 +25,13 @@ auto is_input_dep_cfi           (ptr_instruction_t tested_ins) -> bool;
 
 auto is_resolved_cfi            (ptr_instruction_t tested_ins) -> bool;
 
+auto index_saved_instance       (const ptr_cond_direct_ins_t cfi) -> void;
+
 auto look_for_saved_instance    (const ptr_cond_direct_ins_t cfi,
-                                 const path_code_t path_code) -> ptr_cond_direct_ins_t;
+                                 path_code_id_t path_code) -> ptr_cond_direct_ins_t;
+
+auto look_for_saved_instance    (ADDRINT cfi_addr, UINT32 cfi_order,
+                                 path_code_id_t path_code) -> ptr_cond_direct_ins_t;
 
 auto save_static_trace          (const std::string& filename)  -> void;
 
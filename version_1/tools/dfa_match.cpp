@@ -0,0 +1,71 @@
+// matcher of messages against a transition table exported by path_explorer: each message file is a
+// message, or each line of the standard input is a message when no message file is given
+//
+//   usage: dfa_match dfa_abstracted_<pid>.table [message_file ...]
+
+#include "dfa_matcher.h"
+#include "../src/util/tinyformat.h"
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    tfm::format(std::cerr, "usage: %s table_file [message_file ...]\n", argv[0]);
+    return 1;
+  }
+
+  dfa_matcher matcher;
+  if (!matcher.load(argv[1]))
+  {
+    tfm::format(std::cerr, "cannot load the table %s\n", argv[1]);
+    return 1;
+  }
+
+  std::vector<std::string> message_names, message_contents;
+  if (argc > 2)
+  {
+    for (auto arg_idx = 2; arg_idx < argc; ++arg_idx)
+    {
+      std::ifstream message_file(argv[arg_idx], std::ifstream::in | std::ifstream::binary);
+      if (!message_file)
+      {
+        tfm::format(std::cerr, "cannot open %s\n", argv[arg_idx]);
+        return 1;
+      }
+      message_names.push_back(argv[arg_idx]);
+      message_contents.push_back(std::string(std::istreambuf_iterator<char>(message_file),
+                                             std::istreambuf_iterator<char>()));
+    }
+  }
+  else
+  {
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+      message_names.push_back(tfm::format("line %d", message_names.size() + 1));
+      message_contents.push_back(line);
+    }
+  }
+
+  std::vector<dfa_message_t> messages;
+  for (const auto& content : message_contents)
+  {
+    messages.push_back({ reinterpret_cast<const uint8_t*>(content.data()), content.size() });
+  }
+  std::vector<uint8_t> verdicts(messages.size());
+  auto accepted_num = matcher.match_batch(messages.data(), messages.size(), verdicts.data());
+
+  for (auto msg_idx = std::size_t(0); msg_idx < messages.size(); ++msg_idx)
+  {
+    tfm::format(std::cout, "%-8s %s\n", verdicts[msg_idx] ? "accepted" : "rejected",
+                message_names[msg_idx]);
+  }
+  tfm::format(std::cerr, "%d/%d messages accepted\n", accepted_num, messages.size());
+  return 0;
+}
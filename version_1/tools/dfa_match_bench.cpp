@@ -0,0 +1,173 @@
+// throughput benchmark of the matcher on synthetic messages: uniformly random messages, and
+// messages generated by random walks on the table (which keep out of accepting states as long as
+// possible, so that they are read deeply), each matched one by one and in batches
+//
+//   usage: dfa_match_bench dfa_abstracted_<pid>.table [message_num [message_size [repeat_num]]]
+
+#include "dfa_matcher.h"
+#include "../src/util/tinyformat.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef std::vector<std::vector<uint8_t>> corpus_t;
+
+static std::mt19937 random_engine(0x5eed);
+
+/*================================================================================================*/
+
+static auto random_corpus (std::size_t message_num, std::size_t message_size) -> corpus_t
+{
+  std::uniform_int_distribution<int> byte_dist(0, 255);
+  corpus_t corpus(message_num, std::vector<uint8_t>(message_size));
+  for (auto& message : corpus)
+  {
+    for (auto& value : message) value = static_cast<uint8_t>(byte_dist(random_engine));
+  }
+  return corpus;
+}
+
+
+/**
+ * @brief a walk prefers transitions to non-accepting states, then to accepting states; the message
+ * is completed by random bytes when the walk stops
+ */
+static auto walk_corpus (const dfa_matcher& matcher, std::size_t message_num,
+                         std::size_t message_size) -> corpus_t
+{
+  std::vector<std::vector<uint8_t>> bytes_of_class(matcher.class_num());
+  for (auto value = 0; value < 256; ++value)
+  {
+    bytes_of_class[matcher.class_of_byte(static_cast<uint8_t>(value))].push_back(value);
+  }
+  auto pick = [](std::size_t bound) -> std::size_t
+  {
+    return std::uniform_int_distribution<std::size_t>(0, bound - 1)(random_engine);
+  };
+
+  auto corpus = random_corpus(message_num, message_size);
+  for (auto& message : corpus)
+  {
+    auto state = matcher.initial_state();
+    for (auto& value : message)
+    {
+      std::vector<uint8_t> inner_classes, final_classes;
+      for (auto byte_class = uint32_t(0); byte_class < matcher.class_num(); ++byte_class)
+      {
+        auto next_state = matcher.next_state(state, static_cast<uint8_t>(byte_class));
+        if (next_state == dfa_table_reject) continue;
+        (matcher.is_accepting(next_state) ? final_classes : inner_classes).push_back(byte_class);
+      }
+
+      const auto& classes = !inner_classes.empty() ? inner_classes : final_classes;
+      if (classes.empty()) break;
+      auto byte_class = classes[pick(classes.size())];
+      value = bytes_of_class[byte_class][pick(bytes_of_class[byte_class].size())];
+      state = matcher.next_state(state, byte_class);
+      if (matcher.is_accepting(state)) break;
+    }
+  }
+  return corpus;
+}
+
+
+/**
+ * @brief the number of bytes read by the matcher from a message (i.e. until the message is decided)
+ */
+static auto scanned_size (const dfa_matcher& matcher, const std::vector<uint8_t>& message)
+  -> std::size_t
+{
+  auto state = matcher.initial_state(); auto size = std::size_t(0);
+  while ((size < message.size()) && !matcher.is_accepting(state))
+  {
+    state = matcher.next_state(state, matcher.class_of_byte(message[size])); ++size;
+    if (state == dfa_table_reject) break;
+  }
+  return size;
+}
+
+
+static auto run_corpus (const dfa_matcher& matcher, const std::string& name,
+                        const corpus_t& corpus, std::size_t repeat_num) -> void
+{
+  std::vector<dfa_message_t> messages;
+  auto corpus_size = std::size_t(0); auto scanned_corpus_size = std::size_t(0);
+  for (const auto& message : corpus)
+  {
+    messages.push_back({ message.data(), message.size() }); corpus_size += message.size();
+    scanned_corpus_size += scanned_size(matcher, message);
+  }
+  std::vector<uint8_t> verdicts(messages.size());
+
+  // the throughput is of the bytes which are actually read
+  auto throughput = [&](std::chrono::steady_clock::duration elapsed) -> double
+  {
+    auto seconds = std::chrono::duration<double>(elapsed).count();
+    return (seconds > 0) ? (scanned_corpus_size * repeat_num) / (seconds * 1024 * 1024) : 0;
+  };
+
+  auto single_accepted = std::size_t(0);
+  auto start_time = std::chrono::steady_clock::now();
+  for (auto repeat = std::size_t(0); repeat < repeat_num; ++repeat)
+  {
+    for (const auto& message : messages)
+    {
+      if (matcher.match(message.data, message.size)) ++single_accepted;
+    }
+  }
+  auto single_elapsed = std::chrono::steady_clock::now() - start_time;
+
+  auto batch_accepted = std::size_t(0);
+  start_time = std::chrono::steady_clock::now();
+  for (auto repeat = std::size_t(0); repeat < repeat_num; ++repeat)
+  {
+    batch_accepted += matcher.match_batch(messages.data(), messages.size(), verdicts.data());
+  }
+  auto batch_elapsed = std::chrono::steady_clock::now() - start_time;
+
+  tfm::format(std::cout, "%-8s %8d messages %10d bytes (%10d read) %8d accepted  "
+              "single: %9.2f MB/s  batch: %9.2f MB/s\n", name, messages.size(), corpus_size,
+              scanned_corpus_size, batch_accepted / repeat_num, throughput(single_elapsed),
+              throughput(batch_elapsed));
+  if (single_accepted != batch_accepted)
+  {
+    tfm::format(std::cerr, "single and batch matching disagree: %d/%d accepted\n",
+                single_accepted / repeat_num, batch_accepted / repeat_num);
+  }
+  return;
+}
+
+
+int main(int argc, char* argv[])
+{
+  if ((argc < 2) || (argc > 5))
+  {
+    tfm::format(std::cerr, "usage: %s table_file [message_num [message_size [repeat_num]]]\n",
+                argv[0]);
+    return 1;
+  }
+
+  dfa_matcher matcher;
+  if (!matcher.load(argv[1]))
+  {
+    tfm::format(std::cerr, "cannot load the table %s\n", argv[1]);
+    return 1;
+  }
+
+  auto message_num  = (argc > 2) ? std::stoul(argv[2]) : 10000;
+  auto message_size = (argc > 3) ? std::stoul(argv[3]) : 1024;
+  auto repeat_num   = (argc > 4) ? std::stoul(argv[4]) : 10;
+  if ((message_num == 0) || (repeat_num == 0))
+  {
+    tfm::format(std::cerr, "message_num and repeat_num must be positive\n");
+    return 1;
+  }
+
+  tfm::format(std::cout, "%d states, %d byte classes\n", matcher.state_num(), matcher.class_num());
+  run_corpus(matcher, "random", random_corpus(message_num, message_size), repeat_num);
+  run_corpus(matcher, "walk", walk_corpus(matcher, message_num, message_size), repeat_num);
+  return 0;
+}
@@ -0,0 +1,143 @@
+#include "dfa_matcher.h"
+
+#include <algorithm>
+#include <fstream>
+
+// messages of a batch are matched in lanes: the lanes are advanced together so that the loads of
+// independent table lookups overlap
+static const std::size_t lane_num = 8;
+
+/*================================================================================================*/
+
+dfa_matcher::dfa_matcher() : initial_offset(0), accept_offset(0), reject_offset(0)
+{
+  header = dfa_table_header_t();
+  std::fill(byte_class, byte_class + 256, 0);
+}
+
+
+/**
+ * @brief dfa_matcher::load: load and check a table, then build the matching table
+ */
+auto dfa_matcher::load (const std::string& filename) -> bool
+{
+  std::ifstream table_file(filename.c_str(), std::ifstream::in | std::ifstream::binary);
+  if (!table_file) return false;
+
+  if (!table_file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      (header.magic != dfa_table_magic) || (header.version != dfa_table_version) ||
+      (header.state_num == 0) || (header.class_num == 0) || (header.class_num > 256) ||
+      (header.initial_state >= header.state_num) ||
+      (static_cast<uint64_t>(header.state_num + 2) * header.class_num > dfa_table_reject))
+    return false;
+
+  accepting.resize(header.state_num);
+  table.resize(static_cast<std::size_t>(header.state_num) * header.class_num);
+  if (!table_file.read(reinterpret_cast<char*>(byte_class), sizeof(byte_class)) ||
+      !table_file.read(reinterpret_cast<char*>(accepting.data()), accepting.size()) ||
+      !table_file.read(reinterpret_cast<char*>(table.data()), table.size() * sizeof(uint32_t)))
+    return false;
+
+  if (std::any_of(byte_class, byte_class + 256,
+                  [&](uint8_t value_class) { return value_class >= header.class_num; }) ||
+      std::any_of(table.begin(), table.end(), [&](uint32_t state)
+  {
+    return (state != dfa_table_reject) && (state >= header.state_num);
+  })) return false;
+
+  auto class_num = header.class_num;
+  accept_offset = header.state_num * class_num; reject_offset = accept_offset + class_num;
+  auto offset_of_state = [&](uint32_t state) -> uint32_t
+  {
+    if (state == dfa_table_reject) return reject_offset;
+    return accepting[state] ? accept_offset : state * class_num;
+  };
+
+  next_offset.resize(table.size() + 2 * class_num);
+  std::transform(table.begin(), table.end(), next_offset.begin(), offset_of_state);
+  std::fill(next_offset.begin() + accept_offset, next_offset.begin() + reject_offset,
+            accept_offset);
+  std::fill(next_offset.begin() + reject_offset, next_offset.end(), reject_offset);
+  initial_offset = offset_of_state(header.initial_state);
+  return true;
+}
+
+
+auto dfa_matcher::next_state (uint32_t state, uint8_t byte_class) const -> uint32_t
+{
+  return table[static_cast<std::size_t>(state) * header.class_num + byte_class];
+}
+
+
+auto dfa_matcher::match (const uint8_t* data, std::size_t size) const -> bool
+{
+  auto offset = initial_offset;
+  for (auto data_end = data + size; (data != data_end) && (offset < accept_offset); ++data)
+  {
+    offset = next_offset[offset + byte_class[*data]];
+  }
+  return offset == accept_offset;
+}
+
+
+/**
+ * @brief dfa_matcher::match_batch: match messages, the verdict of each message (1: accepted, 0:
+ * rejected) is stored in verdicts, the number of accepted messages is returned
+ */
+auto dfa_matcher::match_batch (const dfa_message_t* messages, std::size_t message_num,
+                               uint8_t* verdicts) const -> std::size_t
+{
+  auto accepted_num = std::size_t(0);
+  auto lane_message = std::vector<std::size_t>();
+  const uint8_t* lane_data[lane_num];
+  std::size_t lane_rest[lane_num]; uint32_t lane_offset[lane_num];
+
+  auto next_message = std::size_t(0);
+  while ((next_message < message_num) || !lane_message.empty())
+  {
+    // refill the free lanes
+    while ((lane_message.size() < lane_num) && (next_message < message_num))
+    {
+      auto lane = lane_message.size();
+      lane_message.push_back(next_message);
+      lane_data[lane] = messages[next_message].data; lane_rest[lane] = messages[next_message].size;
+      lane_offset[lane] = initial_offset;
+      ++next_message;
+    }
+
+    // advance all lanes until one of them is decided or the shortest one is read
+    auto step_num = lane_rest[0]; auto is_decided = false;
+    for (auto lane = std::size_t(0); lane < lane_message.size(); ++lane)
+    {
+      is_decided = is_decided || (lane_offset[lane] >= accept_offset);
+      step_num = std::min(step_num, lane_rest[lane]);
+    }
+    auto step = std::size_t(0);
+    for (; !is_decided && (step < step_num); ++step)
+    {
+      for (auto lane = std::size_t(0); lane < lane_message.size(); ++lane)
+      {
+        lane_offset[lane] = next_offset[lane_offset[lane] + byte_class[*lane_data[lane]++]];
+        is_decided |= (lane_offset[lane] >= accept_offset);
+      }
+    }
+
+    // retire the decided lanes by moving the last lane into their places
+    for (auto lane = std::size_t(0); lane < lane_message.size(); ++lane) lane_rest[lane] -= step;
+    auto lane = std::size_t(0);
+    while (lane < lane_message.size())
+    {
+      if ((lane_offset[lane] < accept_offset) && (lane_rest[lane] > 0)) { ++lane; continue; }
+
+      auto is_accepted = (lane_offset[lane] == accept_offset);
+      verdicts[lane_message[lane]] = is_accepted ? 1 : 0;
+      if (is_accepted) ++accepted_num;
+
+      auto last_lane = lane_message.size() - 1;
+      lane_message[lane] = lane_message[last_lane]; lane_data[lane] = lane_data[last_lane];
+      lane_rest[lane] = lane_rest[last_lane]; lane_offset[lane] = lane_offset[last_lane];
+      lane_message.pop_back();
+    }
+  }
+  return accepted_num;
+}
@@ -0,0 +1,53 @@
+#ifndef DFA_MATCHER_H
+#define DFA_MATCHER_H
+
+// standalone matcher of the transition tables exported by path_explorer (abstracted_<pid>.table),
+// it does not depend on Pin. A message is accepted iff reading its bytes from the initial state
+// reaches an accepting state, the remaining bytes are then not read.
+
+#include "../src/util/dfa_table.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct dfa_message_t
+{
+  const uint8_t*  data;
+  std::size_t     size;
+};
+
+class dfa_matcher
+{
+public:
+  dfa_matcher                 ();
+
+  auto load                   (const std::string& filename)       -> bool;
+
+  auto match                  (const uint8_t* data, std::size_t size) const -> bool;
+  auto match_batch            (const dfa_message_t* messages, std::size_t message_num,
+                               uint8_t* verdicts) const           -> std::size_t;
+
+  auto state_num              () const -> uint32_t { return header.state_num; }
+  auto class_num              () const -> uint32_t { return header.class_num; }
+  auto initial_state          () const -> uint32_t { return header.initial_state; }
+  auto class_of_byte          (uint8_t value) const -> uint8_t { return byte_class[value]; }
+  auto is_accepting           (uint32_t state) const -> bool { return accepting[state] != 0; }
+  auto next_state             (uint32_t state, uint8_t byte_class) const -> uint32_t;
+
+private:
+  dfa_table_header_t          header;
+  uint8_t                     byte_class[256];
+  std::vector<uint8_t>        accepting;
+  std::vector<uint32_t>       table;
+
+  // the matching table: rows are premultiplied by class_num, transitions to accepting states go to
+  // the accepting sink and rejects go to the rejecting sink; both sinks loop on themselves and are
+  // the two last rows, so a message is decided once its offset is not less than accept_offset
+  std::vector<uint32_t>       next_offset;
+  uint32_t                    initial_offset;
+  uint32_t                    accept_offset;
+  uint32_t                    reject_offset;
+};
+
+#endif // DFA_MATCHER_H
@@ -0,0 +1,141 @@
+// offline printer of the binary events logged by path_explorer (option -e 1): the events are printed
+// in the same text format as the former debug log of the tainting phase
+//
+//   usage: event_printer <pid>_path_explorer.events <pid>_path_explorer.symbols
+
+#include "../src/util/event_record.h"
+#include "../src/util/tinyformat.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <map>
+
+struct ins_symbol_t
+{
+  std::string disassembled_name;
+  std::string contained_image;
+  std::string contained_function;
+};
+
+static std::map<uint64_t, ins_symbol_t> ins_symbol_at_addr;
+static std::map<uint64_t, std::string>  reg_name_at_value;
+
+/*================================================================================================*/
+
+static auto hexstring (uint64_t input) -> std::string
+{
+  std::ostringstream num_stream;
+  num_stream << "0x" << std::hex << input;
+  return num_stream.str();
+}
+
+
+static auto load_symbols (std::ifstream& symbol_file) -> void
+{
+  std::string line, kind, value;
+  while (std::getline(symbol_file, line))
+  {
+    std::istringstream fields(line);
+    std::getline(fields, kind, '\t'); std::getline(fields, value, '\t');
+
+    if (kind == "ins")
+    {
+      ins_symbol_t symbol;
+      std::getline(fields, symbol.disassembled_name, '\t');
+      std::getline(fields, symbol.contained_image, '\t');
+      std::getline(fields, symbol.contained_function, '\t');
+      ins_symbol_at_addr[std::stoull(value)] = symbol;
+    }
+    else if (kind == "reg")
+    {
+      std::getline(fields, reg_name_at_value[std::stoull(value)], '\t');
+    }
+  }
+  return;
+}
+
+
+/**
+ * @brief an instruction line is ended by its image and function, after its register values
+ */
+static auto end_instruction_line (const ins_symbol_t* symbol) -> void
+{
+  if (symbol)
+  {
+    tfm::format(std::cout, " %-25s %-25s\n", symbol->contained_image, symbol->contained_function);
+  }
+  return;
+}
+
+
+int main(int argc, char* argv[])
+{
+  if (argc != 3)
+  {
+    tfm::format(std::cerr, "usage: %s events_file symbols_file\n", argv[0]);
+    return 1;
+  }
+
+  std::ifstream event_file(argv[1], std::ifstream::in | std::ifstream::binary);
+  std::ifstream symbol_file(argv[2], std::ifstream::in);
+  if (!event_file || !symbol_file)
+  {
+    tfm::format(std::cerr, "cannot open %s or %s\n", argv[1], argv[2]);
+    return 1;
+  }
+  load_symbols(symbol_file);
+
+  static const ins_symbol_t unknown_symbol = { "unknown", "", "" };
+  const ins_symbol_t* open_ins_symbol = 0;
+  bool checkpoint_line_is_open = false;
+
+  event_record_t record;
+  while (event_file.read(reinterpret_cast<char*>(&record), sizeof(record)))
+  {
+    // close the current line if the record does not continue it
+    if ((record.type != register_event) && open_ins_symbol)
+    {
+      end_instruction_line(open_ins_symbol); open_ins_symbol = 0;
+    }
+    if ((record.type != memory_event) && checkpoint_line_is_open)
+    {
+      std::cout << "\n"; checkpoint_line_is_open = false;
+    }
+
+    switch (record.type)
+    {
+    case instruction_event:
+    {
+      auto symbol_iter = ins_symbol_at_addr.find(record.address);
+      open_ins_symbol = (symbol_iter != ins_symbol_at_addr.end()) ? &symbol_iter->second
+                                                                  : &unknown_symbol;
+      tfm::format(std::cout, "%-4d %-15s %-50s ", record.exec_order, hexstring(record.address),
+                  open_ins_symbol->disassembled_name);
+      break;
+    }
+
+    case register_event:
+      tfm::format(std::cout, "(%s: %s)", reg_name_at_value[record.address], hexstring(record.value));
+      break;
+
+    case checkpoint_event:
+      tfm::format(std::cout, "checkpoint detected at %d because memory is read ", record.exec_order);
+      checkpoint_line_is_open = true;
+      break;
+
+    case memory_event:
+      tfm::format(std::cout, "(%s: %d)", hexstring(record.address), record.value);
+      break;
+
+    default:
+      tfm::format(std::cerr, "unknown event type %d\n", record.type);
+      return 1;
+    }
+  }
+
+  end_instruction_line(open_ins_symbol);
+  if (checkpoint_line_is_open) std::cout << "\n";
+  return 0;
+}
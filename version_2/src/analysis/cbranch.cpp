@@ -19,6 +19,7 @@
 
 #include "cbranch.h"
 #include "../main.h"
+#include <vector>
 
 namespace analysis 
 {
@@ -47,17 +48,20 @@ cbranch::cbranch(const instruction& other_instruction) : instruction(other_instr
 
 
 /**
- * @brief Save the current input that leads to the current branch decision.
+ * @brief Save the current input that leads to the current branch decision, the input is interned 
+ * so identical inputs are saved once and inputs differing from the base in a few bytes are saved 
+ * as patches.
  * 
  * @param current_branch_decision current decision
  * @return void
  */
 void cbranch::save_current_input(bool current_branch_decision)
 {
-  ptr_uint8_t new_input_buff(new UINT8[received_message_length]);
-  PIN_SafeCopy(new_input_buff.get(), reinterpret_cast<UINT8*>(received_message_address), 
+  std::vector<UINT8> current_input(received_message_length);
+  PIN_SafeCopy(&current_input[0], reinterpret_cast<UINT8*>(received_message_address), 
                received_message_length);
-  this->inputs_lead_to_decision[current_branch_decision].insert(new_input_buff);
+  this->inputs_lead_to_decision[current_branch_decision].insert(
+    input_snapshot::intern(&current_input[0], received_message_length));
   return;
 }
 
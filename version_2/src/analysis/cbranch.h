@@ -21,6 +21,7 @@
 #define CBRANCH_H
 
 #include "instruction.h"
+#include "input_store.h"
 #include <boost/shared_ptr.hpp>
 #include <boost/unordered_set.hpp>
 #include <boost/unordered_map.hpp>
@@ -30,6 +31,7 @@ namespace analysis
 
 typedef boost::shared_ptr<UINT8> ptr_uint8_t;
 typedef boost::unordered_set<ptr_uint8_t> ptr_uint8s_t;
+typedef boost::unordered_set<ptr_input_t> ptr_inputs_t;
 
 class cbranch : public instruction
 {
@@ -38,7 +40,7 @@ public:
   bool is_resolved;
   bool is_bypassed;
   
-  boost::unordered_map<bool, ptr_uint8s_t> inputs_lead_to_decision;
+  boost::unordered_map<bool, ptr_inputs_t> inputs_lead_to_decision;
 
 public:
   cbranch(const INS& current_instruction);
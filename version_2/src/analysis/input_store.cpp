@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2013  Ta Thanh Dinh <thanhdinh.ta@inria.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "input_store.h"
+#include <boost/weak_ptr.hpp>
+#include <boost/checked_delete.hpp>
+#include <algorithm>
+
+namespace analysis 
+{
+
+// interned inputs are indexed by the hash of their content, the store does not own them so an 
+// input is released once no branch holds it anymore
+typedef boost::weak_ptr<const input_snapshot>                       weak_ptr_input_t;
+static boost::unordered_multimap<UINT64, weak_ptr_input_t>          input_at_hash;
+
+// new inputs are patched against the latest base, an input is stored as a patch if at most 
+// 1/MAX_PATCH_RATIO of its bytes differ from the base
+static ptr_input_t latest_base;
+
+#define MAX_PATCH_RATIO 8
+
+/**
+ * @brief get the value of the input at an offset.
+ * 
+ * @param offset offset of the byte
+ * @return UINT8
+ */
+UINT8 input_snapshot::byte_at(UINT32 offset) const
+{
+  if (this->base_bytes) 
+  {
+    return this->base_bytes.get()[offset];
+  }
+  
+  boost::unordered_map<UINT32, UINT8>::const_iterator patch_iter = 
+    this->patched_bytes.find(offset);
+  if (patch_iter != this->patched_bytes.end()) 
+  {
+    return patch_iter->second;
+  }
+  return this->base->byte_at(offset);
+}
+
+
+/**
+ * @brief FNV-1a hash of the content of a buffer.
+ * 
+ * @param buffer examined buffer
+ * @param buffer_size size of the buffer
+ * @return UINT64
+ */
+static UINT64 hash_of_buffer(const UINT8* buffer, UINT32 buffer_size)
+{
+  UINT64 buffer_hash = 0xcbf29ce484222325ULL;
+  UINT32 offset;
+  for (offset = 0; offset < buffer_size; ++offset) 
+  {
+    buffer_hash = (buffer_hash ^ buffer[offset]) * 0x100000001b3ULL;
+  }
+  return buffer_hash;
+}
+
+
+/**
+ * @brief verify if an input has the content of a buffer.
+ * 
+ * @param input examined input
+ * @param buffer examined buffer
+ * @param buffer_size size of the buffer
+ * @return bool
+ */
+static bool input_has_content(const input_snapshot& input, const UINT8* buffer, 
+                              UINT32 buffer_size)
+{
+  UINT32 offset;
+  if (input.size != buffer_size) 
+  {
+    return false;
+  }
+  
+  for (offset = 0; offset < buffer_size; ++offset) 
+  {
+    if (input.byte_at(offset) != buffer[offset]) 
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/**
+ * @brief get the interned input having the content of a buffer, a new input is interned if there 
+ * is not any one.
+ * 
+ * @param buffer content of the input
+ * @param buffer_size size of the input
+ * @return ptr_input_t
+ */
+ptr_input_t input_snapshot::intern(const UINT8* buffer, UINT32 buffer_size)
+{
+  UINT64 input_hash = hash_of_buffer(buffer, buffer_size);
+  UINT32 offset;
+  ptr_input_t interned_input;
+  
+  // look for an interned input of the same content, released inputs are removed on the way
+  std::pair<boost::unordered_multimap<UINT64, weak_ptr_input_t>::iterator, 
+            boost::unordered_multimap<UINT64, weak_ptr_input_t>::iterator> hash_range = 
+    input_at_hash.equal_range(input_hash);
+  boost::unordered_multimap<UINT64, weak_ptr_input_t>::iterator input_iter = hash_range.first;
+  while (input_iter != hash_range.second) 
+  {
+    interned_input = input_iter->second.lock();
+    if (!interned_input) 
+    {
+      input_iter = input_at_hash.erase(input_iter);
+    }
+    else 
+    {
+      if (input_has_content(*interned_input, buffer, buffer_size)) 
+      {
+        return interned_input;
+      }
+      ++input_iter;
+    }
+  }
+  
+  boost::shared_ptr<input_snapshot> new_input(new input_snapshot());
+  new_input->size = buffer_size;
+  
+  // verify if the buffer differs from the latest base in a few bytes
+  if (latest_base && (latest_base->size == buffer_size)) 
+  {
+    for (offset = 0; offset < buffer_size; ++offset) 
+    {
+      if (buffer[offset] != latest_base->base_bytes.get()[offset]) 
+      {
+        new_input->patched_bytes[offset] = buffer[offset];
+        if (new_input->patched_bytes.size() > buffer_size / MAX_PATCH_RATIO) 
+        {
+          break;
+        }
+      }
+    }
+  }
+  
+  if (latest_base && (latest_base->size == buffer_size) && 
+      (new_input->patched_bytes.size() <= buffer_size / MAX_PATCH_RATIO)) 
+  {
+    // yes, then the new input is a patch against the base
+    new_input->base = latest_base;
+  }
+  else 
+  {
+    // no, then the new input holds all bytes and becomes the latest base
+    new_input->patched_bytes.clear();
+    new_input->base_bytes.reset(new UINT8[buffer_size], boost::checked_array_deleter<UINT8>());
+    std::copy(buffer, buffer + buffer_size, new_input->base_bytes.get());
+    latest_base = new_input;
+  }
+  
+  input_at_hash.insert(std::make_pair(input_hash, weak_ptr_input_t(new_input)));
+  return new_input;
+}
+
+} // end of analysis namespace
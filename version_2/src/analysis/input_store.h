@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2013  Ta Thanh Dinh <thanhdinh.ta@inria.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef INPUT_STORE_H
+#define INPUT_STORE_H
+
+#include <pin.H>
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace analysis 
+{
+
+class input_snapshot;
+typedef boost::shared_ptr<const input_snapshot> ptr_input_t;
+
+/**
+ * @brief class representing an interned input: either a base holding all bytes of the input or a 
+ * sparse patch of bytes against a base. Inputs are immutable, identical inputs are interned into 
+ * a single object so that they are shared by all conditional branches.
+ * 
+ */
+class input_snapshot
+{
+public:
+  UINT32                                size;
+  boost::shared_ptr<UINT8>              base_bytes;
+  ptr_input_t                           base;
+  boost::unordered_map<UINT32, UINT8>   patched_bytes;
+  
+public:
+  UINT8 byte_at(UINT32 offset) const;
+  static ptr_input_t intern(const UINT8* buffer, UINT32 buffer_size);
+};
+
+} // end of analysis namespace
+
+#endif // INPUT_STORE_H
@@ -57,7 +57,6 @@ static void switch_to_trace_resolving_state()
 {
 //   dataflow::extract_inputs_instructions_dependance_maps();
   dbi::set_instrumentation_state(trace_resolving_state);
-  PIN_RemoveInstrumentation();
   return;
 }
   
@@ -109,6 +108,8 @@ void analyzer::normal_instruction_callback(ADDRINT instruction_address)
   {
     // log the instruction
     current_execorder++;
+    path_hash_at_execorder.push_back(utils::extend_path_hash(path_hash_at_execorder.back(), 
+                                                             instruction_address));
     // first get its static information
     ptr_instruction_t curr_ins = instruction_at_address[instruction_address];
     // then duplicate it using copy constructor instead of constructing from a PIN instruction 
@@ -202,6 +203,22 @@ void analyzer::dataflow_propagation_callback()
 }
 
 
+/**
+ * @brief verify if a memory read overlaps the input buffer. The function is simple enough to be 
+ * inlined by PIN as the "if" part of the checkpoint storing callback, so the cpu context is 
+ * materialized only for instructions reading the input.
+ * 
+ * @param memory_read_address beginning of the read address
+ * @param memory_read_size size of the read address
+ * @return ADDRINT
+ */
+ADDRINT analyzer::input_reading_predicate(ADDRINT memory_read_address, UINT32 memory_read_size)
+{
+  return ((memory_read_address < received_message_address + received_message_length) && 
+          (received_message_address < memory_read_address + memory_read_size));
+}
+
+
 /**
  * @brief callback for storing checkpoint.
  * 
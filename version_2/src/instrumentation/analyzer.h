@@ -38,6 +38,8 @@ public:
   static void mwrite_instruction_callback   (ADDRINT memory_written_address,
                                              UINT32 memory_written_size);
   static void dataflow_propagation_callback ();
+  static ADDRINT input_reading_predicate    (ADDRINT memory_read_address, 
+                                             UINT32 memory_read_size);
   static void checkpoint_storing_callback   (CONTEXT* cpu_context);
 };
 
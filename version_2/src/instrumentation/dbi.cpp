@@ -21,8 +21,10 @@
 #include "../main.h"
 #include "analyzer.h"
 #include "resolver.h"
+#include "tracer.h"
 #include "../analysis/instruction.h"
 #include "../analysis/cbranch.h"
+#include "../utilities/utils.h"
 #include <boost/unordered_map.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/format.hpp>
@@ -31,6 +33,7 @@ namespace instrumentation
 {
 
 using namespace analysis;
+using namespace utilities;
 
 #define SYSCALL_SENDTO            44
 #define SYSCALL_RECVFROM          45
@@ -38,6 +41,7 @@ using namespace analysis;
 
 static instrumentation_state current_instrumentation_state;
 static bool required_message_received = false; 
+static REG state_register;
 
 /**
  * @brief change current running state.
@@ -52,6 +56,31 @@ void dbi::set_instrumentation_state(instrumentation_state new_state)
 }
 
 
+/**
+ * @brief claim a tool register to hold the instrumentation state at the entry of traces, the 
+ * function must be called before the program starts.
+ * 
+ * @return void
+ */
+void dbi::claim_state_register()
+{
+  state_register = PIN_ClaimToolRegister();
+  return;
+}
+
+
+/**
+ * @brief get the current instrumentation state, the returned value is used to select the version 
+ * of the trace that will be executed.
+ * 
+ * @return ADDRINT
+ */
+static ADDRINT current_state_value()
+{
+  return current_instrumentation_state;
+}
+
+
 /**
  * @brief the function is placed to be called immediately before the execution of a system call.
  * 
@@ -141,17 +170,59 @@ static void trace_analyzing_state_handler(const INS& curr_ins, ADDRINT curr_ins_
   ptr_instruction_t curr_ptr_ins = instruction_at_address[curr_ins_addr];
   if (curr_ptr_ins->is_syscall)
   {
-    INS_InsertPredicatedCall(curr_ins, IPOINT_BEFORE, 
-                             (AFUNPTR)analyzer::syscall_instruction_callback, IARG_INST_PTR, 
-                             IARG_END);
+    // in the buffered tracing, the pending records are drained before the system call
+    if (buffered_tracing_enabled) 
+    {
+      INS_InsertPredicatedCall(curr_ins, IPOINT_BEFORE, 
+                               (AFUNPTR)tracer::syscall_instruction_callback, IARG_INST_PTR, 
+                               IARG_CONTEXT, IARG_THREAD_ID, IARG_END);
+    }
+    else 
+    {
+      INS_InsertPredicatedCall(curr_ins, IPOINT_BEFORE, 
+                               (AFUNPTR)analyzer::syscall_instruction_callback, IARG_INST_PTR, 
+                               IARG_END);
+    }
   }
   else 
   {
     if (curr_ptr_ins->is_vdso) 
     {
-      INS_InsertPredicatedCall(curr_ins, IPOINT_BEFORE, 
-                               (AFUNPTR)analyzer::vdso_instruction_callback, IARG_INST_PTR, 
-                               IARG_END);
+      if (buffered_tracing_enabled) 
+      {
+        INS_InsertPredicatedCall(curr_ins, IPOINT_BEFORE, 
+                                 (AFUNPTR)tracer::vdso_instruction_callback, IARG_INST_PTR, 
+                                 IARG_CONTEXT, IARG_THREAD_ID, IARG_END);
+      }
+      else 
+      {
+        INS_InsertPredicatedCall(curr_ins, IPOINT_BEFORE, 
+                                 (AFUNPTR)analyzer::vdso_instruction_callback, IARG_INST_PTR, 
+                                 IARG_END);
+      }
+    }
+    else if (buffered_tracing_enabled) 
+    {
+      // the instruction is logged by a record in the per-thread buffer, but the original values 
+      // at written addresses and the checkpoint must be captured before its execution
+      tracer::instrument_instruction(curr_ins, curr_ptr_ins);
+      
+      if (curr_ptr_ins->is_memwrite) 
+      {
+        INS_InsertPredicatedCall(curr_ins, IPOINT_BEFORE, 
+                                 (AFUNPTR)tracer::mwrite_instruction_callback,
+                                 IARG_MEMORYWRITE_EA, IARG_MEMORYWRITE_SIZE, IARG_END);
+      }
+      
+      if (curr_ptr_ins->is_memread) 
+      {
+        INS_InsertIfPredicatedCall(curr_ins, IPOINT_BEFORE, 
+                                   (AFUNPTR)analyzer::input_reading_predicate, 
+                                   IARG_MEMORYREAD_EA, IARG_MEMORYREAD_SIZE, IARG_END);
+        INS_InsertThenPredicatedCall(curr_ins, IPOINT_BEFORE, 
+                                     (AFUNPTR)tracer::checkpoint_storing_callback, 
+                                     IARG_CONTEXT, IARG_THREAD_ID, IARG_END);
+      }
     }
     else 
     {
@@ -190,12 +261,16 @@ static void trace_analyzing_state_handler(const INS& curr_ins, ADDRINT curr_ins_
                                (AFUNPTR)analyzer::dataflow_propagation_callback, IARG_END);
       
       
-      // capture a callback whenever the instruction read some bytes of the input
+      // capture a callback whenever the instruction read some bytes of the input, the cpu 
+      // context is passed only when the read overlaps the input buffer
       if (curr_ptr_ins->is_memread) 
       {
-        INS_InsertPredicatedCall(curr_ins, IPOINT_BEFORE, 
-                                 (AFUNPTR)analyzer::checkpoint_storing_callback, 
-                                 IARG_CONTEXT, IARG_END);
+        INS_InsertIfPredicatedCall(curr_ins, IPOINT_BEFORE, 
+                                   (AFUNPTR)analyzer::input_reading_predicate, 
+                                   IARG_MEMORYREAD_EA, IARG_MEMORYREAD_SIZE, IARG_END);
+        INS_InsertThenPredicatedCall(curr_ins, IPOINT_BEFORE, 
+                                     (AFUNPTR)analyzer::checkpoint_storing_callback, 
+                                     IARG_CONTEXT, IARG_END);
       }
     }
   }
@@ -208,16 +283,21 @@ static void trace_analyzing_state_handler(const INS& curr_ins, ADDRINT curr_ins_
  * call instructions will never be met because in the trace analyzing state, the execution has been 
  * stopped before meeting a such kind of instructions.
  * 
- * @param instruction handled instruction
- * @param data unused
+ * @param curr_ins handled instruction
+ * @param curr_ins_addr address of the handled instruction
+ * @param ins_is_counted the execution order is already counted by the containing basic block
  * @return void
  */
-static void trace_resolving_state_handler(const INS& curr_ins, ADDRINT curr_ins_addr)
+static void trace_resolving_state_handler(const INS& curr_ins, ADDRINT curr_ins_addr, 
+                                          bool ins_is_counted)
 {
-  // insert generic callback
-  INS_InsertPredicatedCall(curr_ins, IPOINT_BEFORE, 
-                           (AFUNPTR)resolver::generic_instruction_callback, IARG_INST_PTR, 
-                           IARG_END);
+  // insert generic callback if the containing basic block does not count the execution order
+  if (!ins_is_counted) 
+  {
+    INS_InsertPredicatedCall(curr_ins, IPOINT_BEFORE, 
+                             (AFUNPTR)resolver::generic_instruction_callback, IARG_INST_PTR, 
+                             IARG_END);
+  }
   
   // insert callbacks for conditional branch and indirect one, note that the following conditions 
   // are mutually exclusive
@@ -241,16 +321,13 @@ static void trace_resolving_state_handler(const INS& curr_ins, ADDRINT curr_ins_
 
 
 /**
- * @brief the function is placed to be called before the execution of an instruction. Note that the 
- * placement is realized in "loading time", i.e. before the execution of instructions.
+ * @brief create an instruction from the analyzed PIN instruction and store it at its address.
  * 
- * @param instruction instrumented instruction
- * @param data not used
+ * @param current_instruction analyzed instruction
  * @return void
  */
-void dbi::instrument_instruction_before(INS current_instruction, VOID* data)
+static void store_instruction(const INS& current_instruction)
 {
-  // create an instruction from the current analyzed PIN instruction
   ADDRINT current_address = INS_Address(current_instruction);
   ptr_instruction_t curr_ptr_ins(new instruction(current_instruction));
   
@@ -266,30 +343,141 @@ void dbi::instrument_instruction_before(INS current_instruction, VOID* data)
     instruction_at_address[current_address] = curr_ptr_ins;
   }
   
-  // place handlers
-  switch (current_instrumentation_state)
+  return;
+}
+
+
+/**
+ * @brief verify if the execution order can be counted once for a whole basic block, that is the 
+ * case if every instruction of the block is executed exactly once whenever the block is entered, 
+ * i.e. the block contains no predicated instruction (in particular no rep-prefixed one).
+ * 
+ * @param bbl examined basic block
+ * @return bool
+ */
+static bool bbl_is_countable(const BBL& bbl)
+{
+  INS ins;
+  for (ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins)) 
   {
-    case message_receiving_state:
-      // currently do nothing
-      break;
-      
-    case trace_analyzing_state:
-      trace_analyzing_state_handler(current_instruction, current_address);
-      break;
-      
-    case trace_resolving_state:
-      trace_resolving_state_handler(current_instruction, current_address);
-      break;
-      
-    default:
-      BOOST_LOG_TRIVIAL(fatal) 
-        << boost::format("instrumentation falls into a unknown running state %d") 
-            % current_instrumentation_state;
-      PIN_ExitApplication(current_instrumentation_state);
-      break;
+    if (INS_IsPredicated(ins)) 
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/**
+ * @brief the function is placed to be called before the execution of a trace. Each 
+ * instrumentation state has its own version of the trace (the version is the value of the state): 
+ * at the entry of the trace, the current state is loaded into the state register and the execution 
+ * moves to the version of this state if it is not the version of the trace; so switching states 
+ * does not need to remove the instrumentation. 
+ * 
+ * In the trace resolving state, the execution order is counted by a single callback at the entry 
+ * of each countable basic block instead of a generic callback for each instruction; other 
+ * callbacks are still placed for each instruction.
+ * 
+ * @param trace instrumented trace
+ * @param data not used
+ * @return void
+ */
+void dbi::instrument_trace(TRACE trace, VOID* data)
+{
+  BBL bbl;
+  INS ins;
+  bool bbl_is_counted;
+  ADDRINT bbl_hash_mult;
+  ADDRINT bbl_hash_add;
+  ADDRINT state;
+  
+  INS head_ins = BBL_InsHead(TRACE_BblHead(trace));
+  INS_InsertCall(head_ins, IPOINT_BEFORE, (AFUNPTR)current_state_value, 
+                 IARG_RETURN_REGS, state_register, IARG_END);
+  for (state = message_receiving_state; state <= trace_resolving_state; ++state) 
+  {
+    if (state != TRACE_Version(trace)) 
+    {
+      INS_InsertVersionCase(head_ins, state_register, state, state, IARG_END);
+    }
+  }
+  
+  for (bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) 
+  {
+    // the instructions may not be stored yet by the instruction instrumentation
+    for (ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins)) 
+    {
+      if (instruction_at_address.find(INS_Address(ins)) == instruction_at_address.end()) 
+      {
+        store_instruction(ins);
+      }
+    }
+    
+    switch (TRACE_Version(trace)) 
+    {
+      case message_receiving_state:
+        // currently do nothing
+        break;
+        
+      case trace_analyzing_state:
+        for (ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins)) 
+        {
+          trace_analyzing_state_handler(ins, INS_Address(ins));
+        }
+        break;
+        
+      case trace_resolving_state:
+        bbl_is_counted = bbl_is_countable(bbl);
+        if (bbl_is_counted) 
+        {
+          // precompute the factors of the block's rolling hash
+          bbl_hash_mult = 1; bbl_hash_add = 0;
+          for (ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins)) 
+          {
+            bbl_hash_mult = utils::extend_path_hash(bbl_hash_mult, 0);
+            bbl_hash_add = utils::extend_path_hash(bbl_hash_add, INS_Address(ins));
+          }
+          
+          BBL_InsertCall(bbl, IPOINT_BEFORE, (AFUNPTR)resolver::basic_block_callback, 
+                         IARG_ADDRINT, BBL_Address(bbl), IARG_UINT32, BBL_NumIns(bbl), 
+                         IARG_ADDRINT, bbl_hash_mult, IARG_ADDRINT, bbl_hash_add, IARG_END);
+        }
+        
+        for (ins = BBL_InsHead(bbl); INS_Valid(ins); ins = INS_Next(ins)) 
+        {
+          trace_resolving_state_handler(ins, INS_Address(ins), bbl_is_counted);
+        }
+        break;
+        
+      default:
+        BOOST_LOG_TRIVIAL(fatal) 
+          << boost::format("instrumentation falls into a unknown running state %d") 
+              % TRACE_Version(trace);
+        PIN_ExitApplication(TRACE_Version(trace));
+        break;
+    }
   }
   
   return;
 }
+
+
+/**
+ * @brief the function is placed to be called before the execution of an instruction. Note that the 
+ * placement is realized in "loading time", i.e. before the execution of instructions; handlers 
+ * are placed by the trace instrumentation.
+ * 
+ * @param instruction instrumented instruction
+ * @param data not used
+ * @return void
+ */
+void dbi::instrument_instruction_before(INS current_instruction, VOID* data)
+{
+  // create an instruction from the current analyzed PIN instruction
+  store_instruction(current_instruction);
+  return;
+}
   
 }
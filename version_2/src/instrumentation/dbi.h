@@ -37,11 +37,13 @@ class dbi
 {
 public:
   static void set_instrumentation_state(instrumentation_state new_state);
+  static void claim_state_register();
   static void instrument_syscall_enter(THREADID thread_id, CONTEXT *context, 
                                        SYSCALL_STANDARD syscall_std, VOID *data);
   static void instrument_syscall_exit(THREADID thread_id, CONTEXT *context, 
                                       SYSCALL_STANDARD syscall_std, VOID *data);
   static void instrument_instruction_before(INS instruction, VOID* data);
+  static void instrument_trace(TRACE trace, VOID* data);
 };
 
 }
@@ -26,6 +26,7 @@
 #include <boost/integer_traits.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/format.hpp>
+#include <algorithm>
 
 namespace instrumentation 
 {
@@ -36,6 +37,10 @@ using namespace engine;
 static UINT32 pivot_checkpoint_execorder;
 static UINT32 focused_cbranch_execorder;
 static UINT32 local_reexec_number = 0;
+static UINT32 local_flip_number = 0;
+static UINT32 local_max_reexec_number = 0;
+static UINT32 saved_reexec_number = 0;
+static bool local_reexec_is_extended = false;
 
 typedef enum 
 {
@@ -44,6 +49,19 @@ typedef enum
   stop     = 2
 } exec_direction_t;
 
+/**
+ * @brief Reset the re-execution statistics when a new checkpoint (or a new focused branch) is 
+ * examined, its re-execution number is bounded again by the default value.
+ * 
+ * @return void
+ */
+static inline void reset_local_reexec_statistics()
+{
+  local_reexec_number = 0; local_flip_number = 0;
+  local_max_reexec_number = max_local_reexec_number; local_reexec_is_extended = false;
+  return;
+}
+
 /**
  * @brief Calculate the execution order of the first focused branch in this resolving phase.
  * This branch is the first one after the previous resolved branch (fixed in the analyzing phase) 
@@ -58,6 +76,9 @@ void resolver::set_first_focused_cbranch_execorder(UINT32 previous_resolved_cbra
   boost::unordered_map<UINT32, ptr_cbranch_t>::iterator cbranch_iter;
   UINT32 cbranch_execorder;
   
+  // the re-executions saved by given up branches are lent only to branches of the same phase
+  reset_local_reexec_statistics(); saved_reexec_number = 0;
+  
   focused_cbranch_execorder = boost::integer_traits<UINT32>::const_max;
   for (cbranch_iter = cbranch_at_execorder.begin();
        cbranch_iter != cbranch_at_execorder.end(); ++cbranch_iter)
@@ -98,7 +119,9 @@ void resolver::generic_instruction_callback(ADDRINT instruction_address)
   // debug enabled
   if (debug_enabled) 
   {
-    if (instruction_at_execorder[current_execorder]->address != instruction_address) 
+    if ((current_execorder >= path_hash_at_execorder.size()) || 
+        (utils::extend_path_hash(path_hash_at_execorder[current_execorder - 1], 
+                                 instruction_address) != path_hash_at_execorder[current_execorder]))
     {
        BOOST_LOG_TRIVIAL(fatal) 
         << boost::format("meet a wrong instruction at address %s and at execution order %d") 
@@ -111,6 +134,43 @@ void resolver::generic_instruction_callback(ADDRINT instruction_address)
 }
 
 
+/**
+ * @brief Callback applied at the entry of a countable basic block (i.e. without predicated 
+ * instructions), the execution order is advanced directly by the number of its instructions. When 
+ * the debug is enabled, the block is verified to follow the analyzed trace by comparing the 
+ * rolling hash of the trace with the one extended by the block, namely:
+ *                        hash' = hash * block_hash_mult + block_hash_add
+ * 
+ * @param block_address address of the first instruction of the block
+ * @param block_instruction_number number of instructions of the block
+ * @param block_hash_mult multiplicative factor of the block's rolling hash
+ * @param block_hash_add additive factor of the block's rolling hash
+ * @return void
+ */
+void resolver::basic_block_callback(ADDRINT block_address, UINT32 block_instruction_number, 
+                                    ADDRINT block_hash_mult, ADDRINT block_hash_add)
+{
+  UINT32 first_execorder = current_execorder + 1;
+  current_execorder += block_instruction_number;
+  
+  // debug enabled
+  if (debug_enabled) 
+  {
+    if ((current_execorder >= path_hash_at_execorder.size()) || 
+        (path_hash_at_execorder[first_execorder - 1] * block_hash_mult + block_hash_add != 
+         path_hash_at_execorder[current_execorder])) 
+    {
+      BOOST_LOG_TRIVIAL(fatal) 
+        << boost::format("meet a wrong basic block at address %s and at execution order %d") 
+            % utils::addrint2hexstring(block_address) % first_execorder;
+      PIN_ExitApplication(0);
+    }
+  }
+  
+  return;
+}
+
+
 /**
  * @brief Callback applied for a conditional branch. 
  * The semantics of this function is quite sophisticated because each examined branch can fall into 
@@ -175,11 +235,11 @@ void resolver::cbranch_instruction_callback(bool is_branch_taken)
     case backward:
       ++total_reexec_times;
       ++local_reexec_number;
-      if (local_reexec_number < max_local_reexec_number) 
+      if (local_reexec_number < local_max_reexec_number) 
       {
         checkpoint_at_execorder[pivot_checkpoint_execorder]->modify_input();
       }
-      else // that means local_reexec_number == max_local_reexec_number 
+      else // that means local_reexec_number == local_max_reexec_number 
       {
         checkpoint_at_execorder[pivot_checkpoint_execorder]->restore_input();
       }
@@ -224,7 +284,7 @@ static inline exec_direction_t unfocused_newtaken_branch_handler(ptr_cbranch_t e
   }
   
   // because the branch will take a different target if the execution continue, so that implicitly 
-  // means that the local_reexec_number is less than max_local_reexec_number, we increase the local 
+  // means that the local_reexec_number is less than local_max_reexec_number, we increase the local 
   // execution number and back.
   return backward;
 }
@@ -241,12 +301,12 @@ static inline exec_direction_t unfocused_newtaken_branch_handler(ptr_cbranch_t e
 static inline exec_direction_t focused_newtaken_branch_handler(ptr_cbranch_t examined_branch)
 {
   // set it as resolved
-  examined_branch->is_resolved = true;
+  examined_branch->is_resolved = true; ++local_flip_number;
   // and save the current input
   examined_branch->save_current_input(!examined_branch->is_taken);
   
   // because the branch will take a different target if the execution continue, so that implicitly 
-  // means that the local_reexec_number is less than max_local_reexec_number, we increase the local 
+  // means that the local_reexec_number is less than local_max_reexec_number, we increase the local 
   // execution number and back.  
   return backward;
 }
@@ -279,26 +339,57 @@ inline static exec_direction_t focused_oldtaken_branch_handler(ptr_cbranch_t exa
 {
   exec_direction_t exec_direction;
   
-  if (local_reexec_number < max_local_reexec_number - 1) 
+  // the input is modified randomly, so if the branch has not been flipped after n re-executions 
+  // then 3/n is an upper bound (rule of three) of the flipping probability; when this bound is 
+  // negligible, the branch is given up as if its re-execution number were exhausted, and its 
+  // remaining re-executions are saved
+  if ((local_flip_number == 0) && (local_reexec_number > 0) && 
+      (local_reexec_number < local_max_reexec_number - 1) &&
+      (3.0 / local_reexec_number < giveup_probability)) 
+  {
+    saved_reexec_number += local_max_reexec_number - 1 - local_reexec_number;
+    BOOST_LOG_TRIVIAL(info) 
+      << boost::format("the branch at execution order %d is given up after %d re-executions, "
+                       "saved re-executions %d") 
+          % current_execorder % local_reexec_number % saved_reexec_number;
+    local_reexec_number = local_max_reexec_number - 1;
+  }
+  
+  // the re-execution number is exhausted, but the branch is still promising since both decisions 
+  // have been observed, then its bound is extended (once) by the saved re-executions
+  if ((local_reexec_number == local_max_reexec_number - 1) && !local_reexec_is_extended && 
+      (saved_reexec_number > 0) && (local_flip_number > 0) && 
+      (local_flip_number < local_reexec_number))
+  {
+    UINT32 extended_reexec_number = std::min(saved_reexec_number, max_local_reexec_number);
+    local_max_reexec_number += extended_reexec_number; 
+    saved_reexec_number -= extended_reexec_number; local_reexec_is_extended = true;
+    BOOST_LOG_TRIVIAL(info) 
+      << boost::format("the branch at execution order %d is extended by %d re-executions") 
+          % current_execorder % extended_reexec_number;
+  }
+  
+  if (local_reexec_number < local_max_reexec_number - 1) 
   {
     // back again
     exec_direction = backward;
   }
   else 
   {
-    if (local_reexec_number == max_local_reexec_number - 1) 
+    if (local_reexec_number == local_max_reexec_number - 1) 
     {
       // set the examined branch as bypassed and back to the original trace
       examined_branch->is_bypassed = true; exec_direction = backward;
     }
-    else // that means local_reexec_number == max_local_reexec_number
+    else // that means local_reexec_number == local_max_reexec_number
     {
       UINT32 chkpnt_execorder = next_checkpoint_execorder();
       // if the next checkpoint exists
       if (chkpnt_execorder != 0) 
       {
         // then back to the next checkpoint
-        pivot_checkpoint_execorder = chkpnt_execorder; local_reexec_number = 0;
+        pivot_checkpoint_execorder = chkpnt_execorder; 
+        reset_local_reexec_statistics();
         exec_direction = backward;        
       }
       else // the next checkpoint does not exist
@@ -308,7 +399,8 @@ inline static exec_direction_t focused_oldtaken_branch_handler(ptr_cbranch_t exa
         if (cbranch_execorder != boost::integer_traits<UINT32>::const_max) 
         {
           // then continue executing
-          focused_cbranch_execorder = cbranch_execorder; local_reexec_number = 0;
+          focused_cbranch_execorder = cbranch_execorder; 
+          reset_local_reexec_statistics();
           exec_direction = forward;
         }
         else 
@@ -395,12 +487,12 @@ void resolver::indirectBrOrCall_instruction_callback(ADDRINT target_address)
   if (instruction_at_execorder[current_execorder + 1]->address != target_address) 
   {
     ++local_reexec_number;
-    if (local_reexec_number < max_local_reexec_number) 
+    if (local_reexec_number < local_max_reexec_number) 
     {
       // modify the input to try to pass this branch
       checkpoint_at_execorder[pivot_checkpoint_execorder]->modify_input();
     }
-    else // that means local_reexec_number == max_local_reexec_number 
+    else // that means local_reexec_number == local_max_reexec_number 
     {
       // restore the input to back to the original trace
       checkpoint_at_execorder[pivot_checkpoint_execorder]->restore_input();
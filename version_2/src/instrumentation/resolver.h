@@ -31,6 +31,8 @@ class resolver
 public:
   static void set_first_focused_cbranch_execorder(UINT32 previous_resolved_cbranch_execorder);
   static void generic_instruction_callback(ADDRINT instruction_address);
+  static void basic_block_callback(ADDRINT block_address, UINT32 block_instruction_number, 
+                                   ADDRINT block_hash_mult, ADDRINT block_hash_add);
   static void cbranch_instruction_callback(bool is_branch_taken);
   static void indirectBrOrCall_instruction_callback(ADDRINT target_address);
 };
@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2013  Ta Thanh Dinh <thanhdinh.ta@inria.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "tracer.h"
+#include "analyzer.h"
+#include "../main.h"
+#include "../analysis/dataflow.h"
+
+#include <cstddef>
+#include <algorithm>
+#include <boost/log/trivial.hpp>
+#include <boost/format.hpp>
+
+namespace instrumentation 
+{
+
+using namespace analysis;
+
+#define RECORD_BUFFER_PAGES 64
+
+static BUFFER_ID record_buffer_id;
+static TLS_KEY   drained_record_key;
+
+/**
+ * @brief replay a batch of instruction records in the analyzer: each record gives the same 
+ * information as the separated callbacks (normal instruction, conditional branch, memory read, 
+ * memory write and data-flow propagation) of the unbuffered tracing. The records are written up 
+ * to the limit of the trace, the first record past the limit makes the analyzer switch to the 
+ * trace-resolving state (as the normal callback does in the unbuffered tracing) and the records 
+ * after it are not part of the trace.
+ * 
+ * @param first_record the first undrained record
+ * @param last_record the record after the last undrained one
+ * @return false if the limit of the trace is reached
+ */
+static bool drain_records(instruction_record* first_record, instruction_record* last_record)
+{
+  instruction_record* record;
+  ptr_instruction_t curr_ins;
+  UINT32 writable_record_number = exectrace_max_length - std::min(current_execorder, 
+                                                                  exectrace_max_length);
+  
+  for (record = first_record; record < last_record; ++record) 
+  {
+    if (writable_record_number == 0) 
+    {
+      analyzer::normal_instruction_callback(record->instruction_address);
+      return false;
+    }
+    --writable_record_number;
+    
+    analyzer::normal_instruction_callback(record->instruction_address);
+    curr_ins = instruction_at_execorder[current_execorder];
+    
+    if (curr_ins->is_cbranch) 
+    {
+      analyzer::cbranch_instruction_callback(record->is_branch_taken);
+    }
+    
+    if (curr_ins->is_memread) 
+    {
+      curr_ins->update_memory_access_info(record->memory_read_address, 
+                                          record->memory_read_size, MEMORY_READ);
+    }
+    
+    if (curr_ins->is_memwrite) 
+    {
+      curr_ins->update_memory_access_info(record->memory_written_address, 
+                                          record->memory_written_size, MEMORY_WRITE);
+    }
+    
+    dataflow::propagate_along_instruction(current_execorder);
+  }
+  
+  return true;
+}
+
+
+/**
+ * @brief drain the pending records of a thread, i.e. the ones logged before the current 
+ * instruction, so that the analyzer is up to date before a record out of the buffer (a checkpoint, 
+ * a system call or a vdso instruction) is handled.
+ * 
+ * @param cpu_context cpu registers along with their values
+ * @param thread_id the thread executing the instruction
+ * @return false if the limit of the trace is reached
+ */
+static bool drain_pending_records(CONTEXT* cpu_context, THREADID thread_id)
+{
+  instruction_record* drained_record = 
+    static_cast<instruction_record*>(PIN_GetThreadData(drained_record_key, thread_id));
+  instruction_record* current_record = 
+    static_cast<instruction_record*>(PIN_GetBufferPointer(cpu_context, record_buffer_id));
+  
+  PIN_SetThreadData(drained_record_key, current_record, thread_id);
+  return drain_records(drained_record, current_record);
+}
+
+
+/**
+ * @brief called by PIN when the record buffer of a thread is full (or when the thread exits), the 
+ * records which have not been drained yet by a checkpoint storing are drained.
+ * 
+ * @return the buffer to be reused by the thread
+ */
+static VOID* record_buffer_full(BUFFER_ID buffer_id, THREADID thread_id, const CONTEXT* context, 
+                                VOID* buffer, UINT64 record_number, VOID* data)
+{
+  instruction_record* drained_record = 
+    static_cast<instruction_record*>(PIN_GetThreadData(drained_record_key, thread_id));
+  
+  drain_records(drained_record, static_cast<instruction_record*>(buffer) + record_number);
+  
+  // the buffer is reused from its beginning
+  PIN_SetThreadData(drained_record_key, buffer, thread_id);
+  return buffer;
+}
+
+
+/**
+ * @brief the first record to drain of a new thread is the beginning of its buffer.
+ */
+static VOID thread_starting(THREADID thread_id, CONTEXT* context, INT32 flags, VOID* data)
+{
+  PIN_SetThreadData(drained_record_key, PIN_GetBufferPointer(context, record_buffer_id), thread_id);
+  return;
+}
+
+
+/**
+ * @brief define the per-thread record buffers, this must be called before the program starts.
+ * 
+ * @return void
+ */
+void tracer::initialize()
+{
+  record_buffer_id = PIN_DefineTraceBuffer(sizeof(instruction_record), RECORD_BUFFER_PAGES, 
+                                           record_buffer_full, 0);
+  if (record_buffer_id == BUFFER_ID_INVALID) 
+  {
+    BOOST_LOG_TRIVIAL(fatal) << "cannot define the buffer for instruction records";
+    PIN_ExitProcess(1);
+  }
+  
+  drained_record_key = PIN_CreateThreadDataKey(0);
+  PIN_AddThreadStartFunction(thread_starting, 0);
+  return;
+}
+
+
+/**
+ * @brief insert the inlined code filling the record of an instruction in the trace-analyzing 
+ * state, only the fields concerned by the instruction are filled (the others are never read 
+ * because the draining uses the static information of the instruction).
+ * 
+ * @param instruction instrumented instruction
+ * @param ptr_instruction static information of the instrumented instruction
+ * @return void
+ */
+void tracer::instrument_instruction(const INS& instruction, ptr_instruction_t ptr_instruction)
+{
+  IARGLIST record_fields = IARGLIST_Alloc();
+  
+  IARGLIST_AddArguments(record_fields, 
+                        IARG_INST_PTR, offsetof(instruction_record, instruction_address), 
+                        IARG_END);
+  if (ptr_instruction->is_memread) 
+  {
+    IARGLIST_AddArguments(record_fields, 
+                          IARG_MEMORYREAD_EA, offsetof(instruction_record, memory_read_address), 
+                          IARG_MEMORYREAD_SIZE, offsetof(instruction_record, memory_read_size), 
+                          IARG_END);
+  }
+  if (ptr_instruction->is_memwrite) 
+  {
+    IARGLIST_AddArguments(record_fields, 
+                          IARG_MEMORYWRITE_EA, offsetof(instruction_record, memory_written_address), 
+                          IARG_MEMORYWRITE_SIZE, offsetof(instruction_record, memory_written_size), 
+                          IARG_END);
+  }
+  if (ptr_instruction->is_cbranch) 
+  {
+    IARGLIST_AddArguments(record_fields, 
+                          IARG_BRANCH_TAKEN, offsetof(instruction_record, is_branch_taken), 
+                          IARG_END);
+  }
+  
+  INS_InsertFillBufferPredicated(instruction, IPOINT_BEFORE, record_buffer_id, 
+                                 IARG_IARGLIST, record_fields, IARG_END);
+  IARGLIST_Free(record_fields);
+  return;
+}
+
+
+/**
+ * @brief a checkpoint depends on the data-flow until the current instruction, so the records of 
+ * the thread are drained (up to the current one) before storing the checkpoint; no checkpoint is 
+ * stored if the trace has reached its limit meanwhile.
+ * 
+ * @param cpu_context cpu registers along with their values
+ * @param thread_id the thread executing the instruction
+ * @return void
+ */
+void tracer::checkpoint_storing_callback(CONTEXT* cpu_context, THREADID thread_id)
+{
+  if (drain_pending_records(cpu_context, thread_id)) 
+  {
+    analyzer::checkpoint_storing_callback(cpu_context);
+  }
+  return;
+}
+
+
+/**
+ * @brief the pending records are drained before a system call is reported, so that it is reported 
+ * at its place in the trace.
+ * 
+ * @param instruction_address address of the instrumented instruction
+ * @param cpu_context cpu registers along with their values
+ * @param thread_id the thread executing the instruction
+ * @return void
+ */
+void tracer::syscall_instruction_callback(ADDRINT instruction_address, CONTEXT* cpu_context, 
+                                          THREADID thread_id)
+{
+  drain_pending_records(cpu_context, thread_id);
+  analyzer::syscall_instruction_callback(instruction_address);
+  return;
+}
+
+
+/**
+ * @brief the pending records are drained before a vdso instruction is reported, as for a system 
+ * call.
+ * 
+ * @param instruction_address address of the instrumented instruction
+ * @param cpu_context cpu registers along with their values
+ * @param thread_id the thread executing the instruction
+ * @return void
+ */
+void tracer::vdso_instruction_callback(ADDRINT instruction_address, CONTEXT* cpu_context, 
+                                       THREADID thread_id)
+{
+  drain_pending_records(cpu_context, thread_id);
+  analyzer::vdso_instruction_callback(instruction_address);
+  return;
+}
+
+
+/**
+ * @brief the original values at written addresses must be saved before the execution of the 
+ * instruction, they cannot be read later when the records are drained.
+ * 
+ * @param memory_written_address beginning of the written address
+ * @param memory_written_size size of the written address
+ * @return void
+ */
+void tracer::mwrite_instruction_callback(ADDRINT memory_written_address, 
+                                         UINT32 memory_written_size)
+{
+  ADDRINT mem_addr;
+  ADDRINT upper_bound_address = memory_written_address + memory_written_size;
+  
+  for (mem_addr = memory_written_address; mem_addr < upper_bound_address; ++mem_addr) 
+  {
+    if (original_memstate_at_address.find(mem_addr) == original_memstate_at_address.end()) 
+    {
+      original_memstate_at_address[mem_addr] = *(reinterpret_cast<UINT8*>(mem_addr));
+    }
+  }
+  
+  return;
+}
+
+} // end of instrumentation namespace
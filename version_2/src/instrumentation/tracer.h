@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2013  Ta Thanh Dinh <thanhdinh.ta@inria.fr>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <pin.H>
+
+#include "../analysis/instruction.h"
+
+namespace instrumentation 
+{
+
+using namespace analysis;
+
+/**
+ * @brief compact record of an executed instruction in the buffered tracing mode, it is filled 
+ * directly by the inlined code of PIN (no analysis call) then drained in batches.
+ */
+typedef struct 
+{
+  ADDRINT instruction_address;
+  ADDRINT memory_read_address;
+  ADDRINT memory_written_address;
+  UINT32  memory_read_size;
+  UINT32  memory_written_size;
+  BOOL    is_branch_taken;
+} instruction_record;
+
+class tracer
+{
+public:
+  static void initialize();
+  static void instrument_instruction(const INS& instruction, ptr_instruction_t ptr_instruction);
+  static void checkpoint_storing_callback(CONTEXT* cpu_context, THREADID thread_id);
+  static void syscall_instruction_callback(ADDRINT instruction_address, CONTEXT* cpu_context, 
+                                           THREADID thread_id);
+  static void vdso_instruction_callback(ADDRINT instruction_address, CONTEXT* cpu_context, 
+                                        THREADID thread_id);
+  static void mwrite_instruction_callback(ADDRINT memory_written_address, 
+                                          UINT32 memory_written_size);
+};
+
+} // end of instrumentation namespace
+
+#endif // TRACER_H
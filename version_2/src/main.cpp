@@ -19,10 +19,18 @@
 
 #include "main.h"
 #include "instrumentation/dbi.h"
+#include "instrumentation/tracer.h"
 
 using namespace instrumentation;
 
+KNOB<BOOL> buffered_tracing_knob(KNOB_MODE_WRITEONCE, "pintool", "buffered", "0", 
+                                 "log executed instructions into per-thread buffers in analyzing");
+KNOB<FLT64> giveup_probability_knob(KNOB_MODE_WRITEONCE, "pintool", "giveup", "0.001", 
+                                    "flipping probability under which a branch is given up early "
+                                    "(0 to disable)");
+
 bool debug_enabled;
+bool buffered_tracing_enabled;
 
 ADDRINT received_message_address;
 INT32 received_message_length;
@@ -30,6 +38,7 @@ UINT32 current_execorder;
 UINT32 exectrace_max_length;
 UINT32 total_reexec_times;
 UINT32 max_local_reexec_number;
+FLT64 giveup_probability;
 UINT32 min_bridge_length;
 
 boost::unordered_map<ADDRINT, ptr_instruction_t> instruction_at_address;
@@ -43,6 +52,7 @@ boost::unordered_map<ADDRINT, UINT8> original_msgstate_at_address;
 boost::unordered_map<ADDRINT, UINT8> original_memstate_at_address;
 boost::unordered_map<ADDRINT, UINT8> current_memstate_at_address;
 boost::unordered_map<UINT32, UINT32> target_execorder_of_bridge_at_execorder;
+std::vector<ADDRINT> path_hash_at_execorder;
 
 /**
  * @brief callback to initialize trace exploration.
@@ -55,6 +65,7 @@ VOID start_exploring(VOID* data)
   instruction_at_address.clear();
   instruction_at_execorder.clear();
   cbranch_at_execorder.clear();
+  path_hash_at_execorder.assign(1, 0);
   return;
 }
 
@@ -78,9 +89,21 @@ int main(int argc, char* argv[])
   PIN_InitSymbols();
   PIN_Init(argc, argv);
   
+  // the record buffers must be defined before the program starts
+  buffered_tracing_enabled = buffered_tracing_knob.Value();
+  giveup_probability = giveup_probability_knob.Value();
+  if (buffered_tracing_enabled) 
+  {
+    tracer::initialize();
+  }
+  
+  // the register selecting the trace version of the instrumentation state
+  dbi::claim_state_register();
+  
   // setup instrumentation functions
   PIN_AddApplicationStartFunction(start_exploring, 0);
   INS_AddInstrumentFunction(dbi::instrument_instruction_before, 0);
+  TRACE_AddInstrumentFunction(dbi::instrument_trace, 0);
   PIN_AddSyscallEntryFunction(dbi::instrument_syscall_enter, 0);
   PIN_AddSyscallExitFunction(dbi::instrument_syscall_exit, 0);
   PIN_AddFiniFunction(stop_exploring, 0);
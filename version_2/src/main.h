@@ -31,6 +31,7 @@
 #include <boost/cstdint.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/unordered_set.hpp>
+#include <vector>
 
 using namespace analysis;
 using namespace engine;
@@ -40,6 +41,7 @@ typedef boost::unordered_set<ADDRINT> addresses_t;
 typedef boost::unordered_set<ptr_insoperand_t> ptr_insoperands_t;
 
 extern bool debug_enabled;
+extern bool buffered_tracing_enabled;
 
 extern ADDRINT received_message_address;
 extern INT32 received_message_length;
@@ -47,6 +49,7 @@ extern UINT32 current_execorder;
 extern UINT32 exectrace_max_length;
 extern UINT32 total_reexec_times;
 extern UINT32 max_local_reexec_number;
+extern FLT64 giveup_probability;
 extern UINT32 min_bridge_length;
 
 extern boost::unordered_map<ADDRINT, ptr_instruction_t> instruction_at_address;
@@ -60,5 +63,6 @@ extern boost::unordered_map<ADDRINT, UINT8> original_msgstate_at_address;
 extern boost::unordered_map<ADDRINT, UINT8> original_memstate_at_address;
 extern boost::unordered_map<ADDRINT, UINT8> current_memstate_at_address;
 extern boost::unordered_map<UINT32, UINT32> target_execorder_of_bridge_at_execorder;
+extern std::vector<ADDRINT> path_hash_at_execorder;
 
 #endif // MAIN_H
@@ -96,4 +96,18 @@ bool utils::is_in_input_buffer(ADDRINT memory_address)
           (memory_address < received_message_address + received_message_length));
 }
 
+
+/**
+ * @brief extend the rolling hash of an executed trace by the address of the next instruction, so 
+ * the hash of a trace of n instructions is a polynomial of degree n over their addresses.
+ * 
+ * @param path_hash the hash of the executed trace
+ * @param instruction_address address of the next instruction
+ * @return ADDRINT
+ */
+ADDRINT utils::extend_path_hash(ADDRINT path_hash, ADDRINT instruction_address)
+{
+  return path_hash * static_cast<ADDRINT>(0x01000193) + instruction_address;
+}
+
 } // end of utilities namespace
\ No newline at end of file
@@ -33,6 +33,7 @@ public:
   static std::string remove_leading_zeros(std::string input);
   static std::string addrint2hexstring(ADDRINT input);
 	static bool is_in_input_buffer(ADDRINT memory_address);
+  static ADDRINT extend_path_hash(ADDRINT path_hash, ADDRINT instruction_address);
 };
 
 } // end of utilities namespace